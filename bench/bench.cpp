@@ -0,0 +1,868 @@
+#include "pathfinder.h"
+#include "bidirectional_pathfinder.h"
+#include "cluster_graph.h"
+#include "heuristic_cache.h"
+#include "grid_moves.h"
+#include "move_sets.h"
+#include "jump_point_moves.h"
+#include "rolling_horizon.h"
+#include "segment_moves.h"
+#include "shapes.h"
+#include "space.h"
+#include "hog2-utils/ScenarioLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#include <random>
+#include <sstream>
+#include <string>
+
+// Benchmarks print one CSV line per case:
+// name,iterations,operations,ns_per_op,allocs_per_op,bytes_per_op,ops_per_sec
+
+static std::atomic<bool> isCountingAllocations{ false };
+static std::atomic<size_t> allocationsCount{ 0 };
+static std::atomic<size_t> allocatedBytes{ 0 };
+
+static inline void CountAllocation(size_t size)
+{
+  if (isCountingAllocations.load(std::memory_order_relaxed))
+  {
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+}
+
+static inline void* Allocate(size_t size)
+{
+  CountAllocation(size);
+  return std::malloc(size ? size : 1);
+}
+
+// Memory of aligned new is only released by aligned delete, so the two sides use a matching pair
+static inline void* AllocateAligned(size_t size, std::align_val_t alignment)
+{
+  CountAllocation(size);
+  size_t bytes = (size_t) alignment;
+#ifdef _MSC_VER
+  return _aligned_malloc(size ? size : 1, bytes);
+#else
+  // aligned_alloc needs the size to be a multiple of the alignment
+  return std::aligned_alloc(bytes, (std::max(size, size_t(1)) + bytes - 1) / bytes * bytes);
+#endif
+}
+
+static inline void FreeAligned(void* memory)
+{
+#ifdef _MSC_VER
+  _aligned_free(memory);
+#else
+  std::free(memory);
+#endif
+}
+
+// Replaced new and delete are a malloc/free pair, GCC can't see it through inlining
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+  if (void* memory = Allocate(size))
+  {
+    return memory;
+  }
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  if (void* memory = AllocateAligned(size, alignment))
+  {
+    return memory;
+  }
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  FreeAligned(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+/**
+ * Measures only the code between Start and Stop, so benchmarks can prepare data outside.
+ */
+class BenchTimer
+{
+private:
+  std::chrono::steady_clock::time_point startTime;
+  double seconds = 0;
+  size_t allocations = 0;
+  size_t bytes = 0;
+
+public:
+  inline void Start()
+  {
+    allocationsCount = 0;
+    allocatedBytes = 0;
+    isCountingAllocations = true;
+    startTime = std::chrono::steady_clock::now();
+  }
+
+  inline void Stop()
+  {
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+    isCountingAllocations = false;
+    seconds += duration.count();
+    allocations += allocationsCount;
+    bytes += allocatedBytes;
+  }
+
+  double GetSeconds() const { return seconds; }
+  size_t GetAllocations() const { return allocations; }
+  size_t GetBytes() const { return bytes; }
+};
+
+struct BenchConfig
+{
+  std::string filter;
+  double minSeconds = 0.2;
+};
+
+// Runs the iteration until it takes at least minSeconds, each iteration performs operationsCount operations
+void RunBenchmark(const BenchConfig& config, const std::string& name, size_t operationsCount,
+  const std::function<void(BenchTimer&)>& iteration)
+{
+  if (!config.filter.empty() && name.find(config.filter) == std::string::npos)
+  {
+    return;
+  }
+
+  // Warm up caches and lazily allocated memory
+  BenchTimer warmUp;
+  iteration(warmUp);
+
+  BenchTimer timer;
+  size_t iterations = 0;
+  while (iterations < 3 || timer.GetSeconds() < config.minSeconds)
+  {
+    iteration(timer);
+    ++iterations;
+  }
+
+  double operations = (double) iterations * operationsCount;
+  std::cout << name << ","
+    << iterations << ","
+    << (size_t) operations << ","
+    << timer.GetSeconds() * 1e9 / operations << ","
+    << timer.GetAllocations() / operations << ","
+    << timer.GetBytes() / operations << ","
+    << operations / timer.GetSeconds() << "\n";
+}
+
+ArrayType<Move<Point>> OctileMoves()
+{
+  return {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+    Move<Point>{ std::sqrt(2.f), {1, 1}},
+    Move<Point>{ std::sqrt(2.f), {-1, -1}},
+    Move<Point>{ std::sqrt(2.f), {1, -1}},
+    Move<Point>{ std::sqrt(2.f), {-1, 1}},
+  };
+}
+
+std::string ReadFile(const char* fileName)
+{
+  std::ifstream file(fileName, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+std::shared_ptr<RawSpace> ReadMap(const std::string& mapContent)
+{
+  SpaceReader reader;
+  std::istringstream mapStream(mapContent);
+  std::optional<RawSpace> space = reader.FromHogFormat(mapStream);
+  if (!space.has_value())
+  {
+    std::cerr << "bench: failed to read the map\n";
+    std::exit(1);
+  }
+
+  return std::make_shared<RawSpace>(space.value());
+}
+
+template<typename HeapType>
+void BenchmarkHeap(const BenchConfig& config, const std::string& heapName)
+{
+  const size_t nodesCount = 100000;
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> timeDistribution(1, 1000);
+
+  NodesArena<int> arena;
+  for (size_t i = 0; i < nodesCount; ++i)
+  {
+    Time minTime = (Time) timeDistribution(random);
+    arena.Add(Node<int>((int) i, minTime, (Time) timeDistribution(random) / 4));
+  }
+
+  RunBenchmark(config, "heap/" + heapName + "/push_pop", nodesCount, [&](BenchTimer& timer)
+  {
+    NodesArena<int> nodes = arena;
+    HeapType heap(true, nodes);
+
+    timer.Start();
+    for (NodeID node = 0; node < nodesCount; ++node)
+    {
+      heap.Insert(node);
+    }
+    while (heap.Size())
+    {
+      heap.PopMin();
+    }
+    timer.Stop();
+  });
+
+  RunBenchmark(config, "heap/" + heapName + "/improve", nodesCount, [&](BenchTimer& timer)
+  {
+    NodesArena<int> nodes = arena;
+    HeapType heap(true, nodes);
+    for (NodeID node = 0; node < nodesCount; ++node)
+    {
+      heap.Insert(node);
+    }
+
+    timer.Start();
+    for (NodeID node = 0; node < nodesCount; ++node)
+    {
+      heap.ImproveTime(node, nodes[node].minTime / 2);
+    }
+    timer.Stop();
+  });
+}
+
+void BenchmarkSegments(const BenchConfig& config)
+{
+  const size_t operationsCount = 10000;
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> startDistribution(0, 100);
+  std::uniform_real_distribution<float> lengthDistribution(0, 3);
+
+  ArrayType<Segment> segments;
+  for (size_t i = 0; i < operationsCount; ++i)
+  {
+    Time start = startDistribution(random);
+    segments.push_back({ start, start + lengthDistribution(random) });
+  }
+
+  RunBenchmark(config, "segments/add_remove", operationsCount, [&](BenchTimer& timer)
+  {
+    SegmentHolder holder(Segment{ 0, 100 });
+
+    timer.Start();
+    for (size_t i = 0; i < operationsCount; ++i)
+    {
+      if (i % 2)
+      {
+        holder.AddSegment(segments[i]);
+      }
+      else
+      {
+        holder.RemoveSegment(segments[i]);
+      }
+    }
+    timer.Stop();
+  });
+
+  ArrayType<SegmentHolder> holders;
+  for (size_t i = 0; i < operationsCount; ++i)
+  {
+    SegmentHolder holder(Segment{ 0, 100 });
+    holder.RemoveSegment(segments[i]);
+    holder.RemoveSegment(segments[(i * 7 + 1) % operationsCount]);
+    holders.push_back(holder);
+  }
+
+  RunBenchmark(config, "segments/intersect", operationsCount, [&](BenchTimer& timer)
+  {
+    size_t segmentsCount = 0;
+
+    timer.Start();
+    for (size_t i = 0; i + 1 < operationsCount; ++i)
+    {
+      SegmentHolder intersection = holders[i] & holders[i + 1];
+      segmentsCount += intersection.begin() != intersection.end();
+    }
+    timer.Stop();
+
+    if (segmentsCount == 0) std::cerr << "bench: empty intersections\n";
+  });
+}
+
+void BenchmarkSpaces(const BenchConfig& config, const std::string& mapContent)
+{
+  std::shared_ptr<RawSpace> rawSpace = ReadMap(mapContent);
+  size_t cellsCount = (size_t) rawSpace->GetWidth() * rawSpace->GetHeight();
+
+  RunBenchmark(config, "space/read_hog", cellsCount, [&](BenchTimer& timer)
+  {
+    SpaceReader reader;
+    std::istringstream mapStream(mapContent);
+
+    timer.Start();
+    std::optional<RawSpace> space = reader.FromHogFormat(mapStream);
+    timer.Stop();
+
+    if (!space.has_value()) std::cerr << "bench: failed to read the map\n";
+  });
+
+  RunBenchmark(config, "space/read_hog_buffer", cellsCount, [&](BenchTimer& timer)
+  {
+    SpaceReader reader;
+
+    timer.Start();
+    std::optional<RawSpace> space = reader.FromHogFormat(mapContent.data(), mapContent.size());
+    timer.Stop();
+
+    if (!space.has_value()) std::cerr << "bench: failed to read the map\n";
+  });
+
+  Time depth = 100;
+  std::shared_ptr<SpaceTime> spaceTime = std::make_shared<SpaceTime>(depth, *rawSpace);
+  Shape crossShape = { ArrayType<Point>{ {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0} } };
+
+  RunBenchmark(config, "space/update_shape", cellsCount, [&](BenchTimer& timer)
+  {
+    ShapeSpace shapeSpace(depth, spaceTime, crossShape);
+
+    timer.Start();
+    for (int y = 0; y < (int) rawSpace->GetHeight(); ++y)
+    {
+      for (int x = 0; x < (int) rawSpace->GetWidth(); ++x)
+      {
+        shapeSpace.UpdateShape({ x, y });
+      }
+    }
+    timer.Stop();
+  });
+
+  RunBenchmark(config, "space/erode_shape", cellsCount, [&](BenchTimer& timer)
+  {
+    timer.Start();
+    RawSpace eroded = ErodeByShape(*rawSpace, crossShape);
+    timer.Stop();
+  });
+
+  std::shared_ptr<const RawSpace> footprints = std::make_shared<RawSpace>(ErodeByShape(*rawSpace, crossShape));
+  RunBenchmark(config, "space/update_shape_eroded", cellsCount, [&](BenchTimer& timer)
+  {
+    ShapeSpace shapeSpace(depth, spaceTime, crossShape, footprints);
+
+    timer.Start();
+    for (int y = 0; y < (int) rawSpace->GetHeight(); ++y)
+    {
+      for (int x = 0; x < (int) rawSpace->GetWidth(); ++x)
+      {
+        shapeSpace.UpdateShape({ x, y });
+      }
+    }
+    timer.Stop();
+  });
+
+  // A batch of reservations along a row followed by a new version for readers
+  const int publishesCount = 64;
+  RunBenchmark(config, "space/publish_snapshot", publishesCount, [&](BenchTimer& timer)
+  {
+    std::shared_ptr<SpaceTime> writerSpace = std::make_shared<SpaceTime>(depth, *rawSpace);
+    SegmentSpacePublisher publisher(writerSpace);
+    ArrayType<Area> areas;
+
+    timer.Start();
+    for (int i = 0; i < publishesCount; ++i)
+    {
+      areas.clear();
+      for (int x = 0; x < 32; ++x)
+      {
+        areas.push_back(Area{ { x + i, (i * 3) % (int) rawSpace->GetHeight() }, { (Time) x, (Time) x + 1 } });
+      }
+      writerSpace->MakeAreasInaccessable(areas);
+      publisher.Publish();
+    }
+    timer.Stop();
+  });
+}
+
+void BenchmarkPathfinding(const BenchConfig& config, const std::string& mapContent, const char* scenarioFileName)
+{
+  const int queriesCount = 64;
+  std::shared_ptr<RawSpace> rawSpace = ReadMap(mapContent);
+  ScenarioLoader loader(scenarioFileName);
+  if ((int) loader.GetNumExperiments() < queriesCount)
+  {
+    std::cerr << "bench: not enough experiments in " << scenarioFileName << "\n";
+    return;
+  }
+
+  ArrayType<Move<Point>> moves = OctileMoves();
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  std::shared_ptr<GridMoves> gridMoves = std::make_shared<GridMoves>(rawSpace, pointShape, moves);
+
+  RunBenchmark(config, "pathfinder/point", queriesCount, [&](BenchTimer& timer)
+  {
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      Point start = { experiment.GetStartX(), experiment.GetStartY() };
+      Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+      Pathfinder<Point> search(gridMoves, start, std::make_shared<EuclideanHeuristic>(goal));
+      search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+      search.FindCost(goal);
+    }
+    timer.Stop();
+  });
+
+  // Distances from one agent to all goals: A* per goal against one batch search
+  Experiment firstExperiment = loader.GetNthExperiment(0);
+  Point firstStart = { firstExperiment.GetStartX(), firstExperiment.GetStartY() };
+  ArrayType<Point> goals;
+  for (int i = 0; i < queriesCount; ++i)
+  {
+    Experiment experiment = loader.GetNthExperiment(i);
+    goals.push_back({ experiment.GetGoalX(), experiment.GetGoalY() });
+  }
+
+  RunBenchmark(config, "pathfinder/one_to_many_single", queriesCount, [&](BenchTimer& timer)
+  {
+    Pathfinder<Point> search(gridMoves, firstStart, nullptr);
+    search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+
+    timer.Start();
+    for (Point goal : goals)
+    {
+      search.Reset(firstStart, std::make_shared<EuclideanHeuristic>(goal));
+      search.SettleCost(goal);
+    }
+    timer.Stop();
+  });
+
+  RunBenchmark(config, "pathfinder/one_to_many_batch", queriesCount, [&](BenchTimer& timer)
+  {
+    Pathfinder<Point> search(gridMoves, firstStart, std::make_shared<Heuristic<Point>>(firstStart));
+    search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+    ArrayType<Time> costs;
+
+    timer.Start();
+    search.FindCosts(goals, costs);
+    timer.Stop();
+  });
+
+  std::shared_ptr<StaticGridMoves<EightConnectedMoves>> staticMoves = std::make_shared<StaticGridMoves<EightConnectedMoves>>(rawSpace);
+  RunBenchmark(config, "pathfinder/point_static_moves", queriesCount, [&](BenchTimer& timer)
+  {
+    Experiment firstExperiment = loader.GetNthExperiment(0);
+    Pathfinder<Point> search(staticMoves, { firstExperiment.GetStartX(), firstExperiment.GetStartY() }, nullptr);
+    search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      Point start = { experiment.GetStartX(), experiment.GetStartY() };
+      Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+      search.Reset(start, std::make_shared<EuclideanHeuristic>(goal));
+      search.FindCost(goal);
+    }
+    timer.Stop();
+  });
+
+  std::shared_ptr<StaticGridMoves<EightConnectedNoCornerCuttingMoves>> noCuttingMoves =
+    std::make_shared<StaticGridMoves<EightConnectedNoCornerCuttingMoves>>(rawSpace);
+  std::shared_ptr<JumpPointMoves> jumpMoves = std::make_shared<JumpPointMoves>(rawSpace, Point{ 0, 0 });
+  for (auto [name, queryMoves] : { std::make_pair("pathfinder/point_no_corner_cutting", (std::shared_ptr<MoveComponent<Point>>) noCuttingMoves),
+    std::make_pair("pathfinder/point_jps", (std::shared_ptr<MoveComponent<Point>>) jumpMoves) })
+  {
+    RunBenchmark(config, name, queriesCount, [&](BenchTimer& timer)
+    {
+      Experiment firstExperiment = loader.GetNthExperiment(0);
+      Pathfinder<Point> search(queryMoves, { firstExperiment.GetStartX(), firstExperiment.GetStartY() }, nullptr);
+      search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+
+      timer.Start();
+      for (int i = 0; i < queriesCount; ++i)
+      {
+        Experiment experiment = loader.GetNthExperiment(i);
+        Point start = { experiment.GetStartX(), experiment.GetStartY() };
+        Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+        jumpMoves->SetGoal(goal);
+        search.Reset(start, std::make_shared<EuclideanHeuristic>(goal));
+        search.SettleCost(goal);
+      }
+      timer.Stop();
+    });
+  }
+
+  RunBenchmark(config, "pathfinder/point_bidirectional", queriesCount, [&](BenchTimer& timer)
+  {
+    Experiment firstExperiment = loader.GetNthExperiment(0);
+    Point firstStart = { firstExperiment.GetStartX(), firstExperiment.GetStartY() };
+    BidirectionalPathfinder<> search(staticMoves, firstStart, firstStart, nullptr, nullptr);
+    search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      Point start = { experiment.GetStartX(), experiment.GetStartY() };
+      Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+      search.Reset(start, goal, std::make_shared<EuclideanHeuristic>(goal), std::make_shared<EuclideanHeuristic>(start));
+      search.FindCost(goal);
+    }
+    timer.Stop();
+  });
+
+  // Hierarchical abstraction: building it, paths from it and A* guided by it
+  RunBenchmark(config, "hierarchy/build", 1, [&](BenchTimer& timer)
+  {
+    timer.Start();
+    ClusterGraph graph(rawSpace, pointShape, moves, 16);
+    timer.Stop();
+  });
+
+  std::shared_ptr<ClusterGraph> clusterGraph = std::make_shared<ClusterGraph>(rawSpace, pointShape, moves, 16);
+  RunBenchmark(config, "hierarchy/find_path", queriesCount, [&](BenchTimer& timer)
+  {
+    ArrayType<Node<Point>> path;
+
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      clusterGraph->FindPath({ experiment.GetStartX(), experiment.GetStartY() }, { experiment.GetGoalX(), experiment.GetGoalY() }, path);
+    }
+    timer.Stop();
+  });
+
+  RunBenchmark(config, "hierarchy/guided_astar", queriesCount, [&](BenchTimer& timer)
+  {
+    Pathfinder<Point> search(gridMoves, firstStart, nullptr);
+    search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      Point start = { experiment.GetStartX(), experiment.GetStartY() };
+      Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+      search.Reset(start, std::make_shared<HierarchicalHeuristic>(clusterGraph, goal));
+      search.FindCost(goal);
+    }
+    timer.Stop();
+  });
+
+  RunBenchmark(config, "pathfinder/point_reused", queriesCount, [&](BenchTimer& timer)
+  {
+    Experiment firstExperiment = loader.GetNthExperiment(0);
+    Pathfinder<Point> search(gridMoves, { firstExperiment.GetStartX(), firstExperiment.GetStartY() }, nullptr);
+    search.SetGridBounds(rawSpace->GetWidth(), rawSpace->GetHeight());
+
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      Point start = { experiment.GetStartX(), experiment.GetStartY() };
+      Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+      search.Reset(start, std::make_shared<EuclideanHeuristic>(goal));
+      search.FindCost(goal);
+    }
+    timer.Stop();
+  });
+
+  Time depth = 100;
+  std::shared_ptr<SpaceTime> spaceTime = std::make_shared<SpaceTime>(depth, *rawSpace);
+  Shape crossShape = { ArrayType<Point>{ {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0} } };
+  HeuristicCache heuristicCache(rawSpace, moves, queriesCount);
+
+  RunBenchmark(config, "pathfinder/windowed_area", queriesCount, [&](BenchTimer& timer)
+  {
+    std::shared_ptr<ShapeSpace> shapeSpace = std::make_shared<ShapeSpace>(depth, spaceTime, crossShape);
+    std::shared_ptr<SegmentMoves<EightConnectedMoves>> segmentMoves = std::make_shared<SegmentMoves<EightConnectedMoves>>(shapeSpace, depth);
+    // One search is reset for every query, so its memory is reused
+    WindowedPathfinder<Area> search(segmentMoves, Area{ Point{ 0, 0 }, {0, depth} }, nullptr, depth);
+
+    timer.Start();
+    for (int i = 0; i < queriesCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      Point start = { experiment.GetStartX(), experiment.GetStartY() };
+      Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+      std::shared_ptr<Heuristic<Area>> h(new SpaceAdapter<Point, Area>(heuristicCache.Get(goal, crossShape)));
+      search.Reset(Area{ start, {0, depth} }, h);
+      search.FindCost(Area::FromDepth(goal, depth));
+    }
+    timer.Stop();
+  });
+
+  for (Time bound : { 1.5f, 2.f })
+  {
+    std::stringstream boundName;
+    boundName << bound;
+
+    RunBenchmark(config, "pathfinder/windowed_area_weighted_" + boundName.str(), queriesCount, [&](BenchTimer& timer)
+    {
+      std::shared_ptr<ShapeSpace> shapeSpace = std::make_shared<ShapeSpace>(depth, spaceTime, crossShape);
+      std::shared_ptr<SegmentMoves<EightConnectedMoves>> segmentMoves = std::make_shared<SegmentMoves<EightConnectedMoves>>(shapeSpace, depth);
+      // One search is reset for every query, so its memory is reused
+      WindowedPathfinder<Area> search(segmentMoves, Area{ Point{ 0, 0 }, {0, depth} }, nullptr, depth);
+      search.SetHeuristicWeight(bound);
+
+      timer.Start();
+      for (int i = 0; i < queriesCount; ++i)
+      {
+        Experiment experiment = loader.GetNthExperiment(i);
+        Point start = { experiment.GetStartX(), experiment.GetStartY() };
+        Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+        std::shared_ptr<Heuristic<Area>> h(new SpaceAdapter<Point, Area>(heuristicCache.Get(goal, crossShape)));
+        search.Reset(Area{ start, {0, depth} }, h);
+        search.FindCost(Area::FromDepth(goal, depth));
+      }
+      timer.Stop();
+    });
+
+    RunBenchmark(config, "pathfinder/windowed_area_focal_" + boundName.str(), queriesCount, [&](BenchTimer& timer)
+    {
+      std::shared_ptr<ShapeSpace> shapeSpace = std::make_shared<ShapeSpace>(depth, spaceTime, crossShape);
+      std::shared_ptr<SegmentMoves<EightConnectedMoves>> segmentMoves = std::make_shared<SegmentMoves<EightConnectedMoves>>(shapeSpace, depth);
+      // One search is reset for every query, so its memory is reused
+      WindowedPathfinder<Area, NodesFocalList<Area>> search(segmentMoves, Area{ Point{ 0, 0 }, {0, depth} }, nullptr, depth);
+      search.SetSuboptimalityBound(bound);
+
+      timer.Start();
+      for (int i = 0; i < queriesCount; ++i)
+      {
+        Experiment experiment = loader.GetNthExperiment(i);
+        Point start = { experiment.GetStartX(), experiment.GetStartY() };
+        Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+        std::shared_ptr<Heuristic<Area>> h(new SpaceAdapter<Point, Area>(heuristicCache.Get(goal, crossShape)));
+        search.Reset(Area{ start, {0, depth} }, h);
+        search.FindCost(Area::FromDepth(goal, depth));
+      }
+      timer.Stop();
+    });
+
+    RunBenchmark(config, "pathfinder/windowed_area_focal_interval_" + boundName.str(), queriesCount, [&](BenchTimer& timer)
+    {
+      std::shared_ptr<ShapeSpace> shapeSpace = std::make_shared<ShapeSpace>(depth, spaceTime, crossShape);
+      std::shared_ptr<SegmentMoves<EightConnectedMoves>> segmentMoves = std::make_shared<SegmentMoves<EightConnectedMoves>>(shapeSpace, depth);
+      // One search is reset for every query, so its memory is reused
+      WindowedPathfinder<Area, NodesFocalList<Area, FocalByIntervalEnd>> search(segmentMoves, Area{ Point{ 0, 0 }, {0, depth} }, nullptr, depth);
+      search.SetSuboptimalityBound(bound);
+
+      timer.Start();
+      for (int i = 0; i < queriesCount; ++i)
+      {
+        Experiment experiment = loader.GetNthExperiment(i);
+        Point start = { experiment.GetStartX(), experiment.GetStartY() };
+        Point goal = { experiment.GetGoalX(), experiment.GetGoalY() };
+
+        std::shared_ptr<Heuristic<Area>> h(new SpaceAdapter<Point, Area>(heuristicCache.Get(goal, crossShape)));
+        search.Reset(Area{ start, {0, depth} }, h);
+        search.FindCost(Area::FromDepth(goal, depth));
+      }
+      timer.Stop();
+    });
+  }
+}
+
+// Ticks of the lifelong engine, goals are scenario goals handed out in order
+void BenchmarkLifelong(const BenchConfig& config, const std::string& mapContent, const char* scenarioFileName)
+{
+  const int agentsCount = 32;
+  const int ticksCount = 50;
+  std::shared_ptr<RawSpace> rawSpace = ReadMap(mapContent);
+  ScenarioLoader loader(scenarioFileName);
+
+  ArrayType<Point> goals;
+  for (int i = 0; i < (int) loader.GetNumExperiments(); ++i)
+  {
+    Experiment experiment = loader.GetNthExperiment(i);
+    goals.push_back({ experiment.GetGoalX(), experiment.GetGoalY() });
+  }
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  RunBenchmark(config, "lifelong/rolling_horizon_tick", ticksCount, [&](BenchTimer& timer)
+  {
+    RollingHorizonEngine<> engine(rawSpace, pointShape, 20, 5, std::make_shared<GoalQueue>(goals));
+    for (int i = 0; i < (int) loader.GetNumExperiments() && (int) engine.GetAgentsCount() < agentsCount; ++i)
+    {
+      Experiment experiment = loader.GetNthExperiment(i);
+      engine.AddAgent({ experiment.GetStartX(), experiment.GetStartY() });
+    }
+
+    timer.Start();
+    for (int tick = 0; tick < ticksCount; ++tick)
+    {
+      engine.Tick(1);
+    }
+    timer.Stop();
+  });
+}
+
+int main(int argc, char* argv[])
+{
+  BenchConfig config;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+    {
+      config.filter = argv[++i];
+    }
+    else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc)
+    {
+      config.minSeconds = std::atof(argv[++i]);
+    }
+    else
+    {
+      std::cerr << "usage: bench [--filter substring] [--min-time seconds]\n";
+      return 1;
+    }
+  }
+
+  std::string mapContent = ReadFile(TEST_DATA_PATH "/ost003d.map");
+  if (mapContent.empty())
+  {
+    std::cerr << "bench: cannot read " TEST_DATA_PATH "/ost003d.map\n";
+    return 1;
+  }
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "name,iterations,operations,ns_per_op,allocs_per_op,bytes_per_op,ops_per_sec\n";
+
+  BenchmarkHeap<NodesBinaryHeap<int>>(config, "binary");
+  BenchmarkHeap<NodesDaryHeap<int, 4>>(config, "dary4");
+  BenchmarkHeap<NodesBucketQueue<int>>(config, "bucket");
+  BenchmarkSegments(config);
+  BenchmarkSpaces(config, mapContent);
+  BenchmarkPathfinding(config, mapContent, TEST_DATA_PATH "/ost003d-even-1.scen");
+  BenchmarkLifelong(config, mapContent, TEST_DATA_PATH "/ost003d-even-1.scen");
+
+  return 0;
+}
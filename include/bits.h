@@ -0,0 +1,39 @@
+#pragma once
+
+#include <inttypes.h>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit, the word must not be zero
+inline uint32_t CountTrailingZeros(uint64_t word)
+{
+  assert(word != 0);
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return index;
+#else
+  return __builtin_ctzll(word);
+#endif
+}
+
+// Index of the highest set bit, the word must not be zero
+inline uint32_t FindHighestBit(uint64_t word)
+{
+  assert(word != 0);
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse64(&index, word);
+  return index;
+#else
+  return 63 - __builtin_clzll(word);
+#endif
+}
+
+inline uint64_t LowBitsMask(uint32_t count)
+{
+  return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+}
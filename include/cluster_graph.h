@@ -0,0 +1,173 @@
+#pragma once
+
+#include "pathfinder.h"
+#include "grid_moves.h"
+#include "shapes.h"
+#include <memory>
+
+// Entrances at least this many cells wide get a transition at each end instead of one in the middle
+#define CLUSTER_WIDE_ENTRANCE 6
+
+struct ClusterTransition
+{
+  Point from;
+  Point to;
+  Time cost;
+};
+
+/**
+ * Grid moves which stay inside of a rectangle. The node at Source is a virtual origin
+ * with moves to the seeds, so one search can start from several cells with different costs.
+ */
+class ClusterMoves : public MoveComponent<Point>
+{
+protected:
+  std::shared_ptr<GridMoves> moves;
+  Point min;
+  Point max;
+  ArrayType<Move<Point>> seeds;
+
+public:
+  // Outside of every grid
+  static const Point Source;
+
+  ClusterMoves(std::shared_ptr<GridMoves> inMoves);
+
+  // Bounds are inclusive
+  void SetCluster(Point inMin, Point inMax, const ArrayType<Move<Point>>& inSeeds);
+
+  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override;
+  virtual void AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& validMoves) override;
+};
+
+/**
+ * HPA*-style abstraction of a static grid for agents with a shape. The grid is cut into square clusters,
+ * moves between clusters are grouped into entrances and a few transitions of every entrance are kept.
+ * Cells of transitions are the entrance nodes of the abstract graph, their distances inside of each cluster
+ * are precomputed. A query connects its endpoints to the entrances of their clusters, searches the abstract
+ * graph and refines abstract edges into grid paths inside of the clusters.
+ *
+ * Abstract costs are costs of real paths, so they are never lower than the true distances, but can be
+ * slightly higher. Moves must be symmetric and cost at least their Euclidean length, and cells of one entrance
+ * are expected to be connected by moves between Chebyshev neighbors (4- or 8-connected moves).
+ */
+class ClusterGraph
+{
+protected:
+  class AbstractMoves;
+
+  struct Cluster
+  {
+    // Inclusive bounds
+    Point min;
+    Point max;
+
+    // Transitions to clusters with greater indices
+    ArrayType<ClusterTransition> transitions;
+
+    ArrayType<Point> entrances;
+    // Transitions from every entrance to other clusters
+    ArrayType<ArrayType<Move<Point>>> exits;
+    // Distances between entrances inside of the cluster, row-major, negative if there is no path
+    ArrayType<Time> distances;
+  };
+
+  std::shared_ptr<const RawSpace> space;
+  Shape shape;
+  uint32_t clusterSize;
+  // Incremented by every update, see HierarchicalHeuristic
+  uint32_t version = 0;
+  uint32_t clustersX;
+  uint32_t clustersY;
+  int maxMoveOffset = 0;
+
+  std::shared_ptr<GridMoves> moves;
+  std::shared_ptr<ClusterMoves> clusterMoves;
+  Pathfinder<Point> clusterSearch;
+
+  ArrayType<Cluster> clusters;
+  // Index of every entrance in its cluster
+  MapType<Point, uint32_t> entranceIds;
+
+  ArrayType<Move<Point>> validMoves;
+
+protected:
+  void BuildTransitions(uint32_t clusterIndex);
+  void BuildCluster(uint32_t clusterIndex);
+
+  // Resets clusterSearch to start from the seeds inside of the cluster
+  void StartClusterSearch(uint32_t clusterIndex, const ArrayType<Move<Point>>& seeds);
+
+  // Settles costs of the cluster cells from the seeds, the result stays in clusterSearch
+  void SearchCluster(uint32_t clusterIndex, const ArrayType<Move<Point>>& seeds);
+  Time FindClusterCost(Point cell) const;
+
+  // Adds moves between the endpoint and the entrances of its cluster
+  void ConnectOrigin(Point origin, AbstractMoves& abstractMoves);
+  void ConnectGoal(Point goal, AbstractMoves& abstractMoves);
+
+public:
+  ClusterGraph(std::shared_ptr<const RawSpace> inSpace, const Shape& inShape, const ArrayType<Move<Point>>& inMoves,
+    uint32_t inClusterSize);
+
+  ClusterGraph(const ClusterGraph&) = delete;
+
+  /**
+   * Rebuilds the clusters which footprints cover the changed cells, and their neighbors.
+   * Heuristics made before the update find their costs again on their next FindCost.
+   */
+  void UpdateCells(const ArrayType<Point>& cells);
+
+  // Hierarchical query and refinement. Returns false if the abstract graph has no path
+  bool FindPath(Point from, Point to, ArrayType<Node<Point>>& path);
+
+  // Abstract costs to the goal of every entrance which can reach it
+  void FindEntranceCosts(Point goal, MapType<Point, Time>& costs);
+
+  /**
+   * Costs to the goal of every cell of the cluster through the entrances with known costs,
+   * indexed by GetIndexInCluster. Cells which can't reach the goal get negative costs.
+   */
+  void FindCellCosts(uint32_t clusterIndex, Point goal, const MapType<Point, Time>& entranceCosts, ArrayType<Time>& costs);
+
+  bool Contains(Point cell) const { return space->Contains(cell); }
+
+  uint32_t GetClusterIndex(Point cell) const;
+  size_t GetIndexInCluster(Point cell) const;
+
+  size_t GetClustersCount() const { return clusters.size(); }
+  size_t GetEntrancesCount() const { return entranceIds.size(); }
+  const ArrayType<Point>& GetEntrances(uint32_t clusterIndex) const { return clusters[clusterIndex].entrances; }
+  // Row-major distances between the entrances of the cluster, negative if there is no path
+  const ArrayType<Time>& GetDistances(uint32_t clusterIndex) const { return clusters[clusterIndex].distances; }
+  uint32_t GetClusterSize() const { return clusterSize; }
+  uint32_t GetVersion() const { return version; }
+};
+
+/**
+ * Abstract distance to the goal over a ClusterGraph. Costs of entrances are found once,
+ * costs of cells are found by one search per cluster when the cluster is first asked for.
+ * After the graph is updated all costs are dropped and found again by the next FindCost.
+ * The costs can overestimate, so A* with it is fast but not always optimal.
+ */
+class HierarchicalHeuristic : public Heuristic<Point>
+{
+protected:
+  std::shared_ptr<ClusterGraph> graph;
+  Point goal;
+  // Version of the graph the costs are found for
+  uint32_t version;
+  MapType<Point, Time> entranceCosts;
+  ArrayType<ArrayType<Time>> clusterCosts;
+
+public:
+  HierarchicalHeuristic(std::shared_ptr<ClusterGraph> inGraph, Point inGoal);
+
+  virtual bool IsCostFound(Point to) const override;
+
+  virtual Time GetCost(Point to) const override;
+
+  virtual void FindCost(Point to) override;
+
+  virtual Point GetOrigin() const override;
+};
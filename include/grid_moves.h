@@ -0,0 +1,27 @@
+#pragma once
+
+#include "search_types.h"
+#include "space.h"
+#include "shapes.h"
+#include "moves.h"
+#include <memory>
+
+/**
+ * Moves of an agent with a shape over a static grid.
+ * A destination is valid if every point of the shape applied to it is accessable.
+ */
+class GridMoves : public MoveComponent<Point>
+{
+protected:
+  std::shared_ptr<const RawSpace> space;
+  Shape shape;
+  ArrayType<Move<Point>> moves;
+
+public:
+  GridMoves(std::shared_ptr<const RawSpace> inSpace, const Shape& inShape, const ArrayType<Move<Point>>& inMoves);
+
+  bool IsValid(Point point) const;
+
+  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override;
+  virtual void AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& validMoves) override;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "pathfinder.h"
+#include "grid_moves.h"
+#include "shapes.h"
+#include "thread_pool.h"
+#include <memory>
+
+/**
+ * True distance to a goal for agents with a shape on a static grid.
+ * Distances come from a reverse Dijkstra search from the goal which is resumed
+ * by every FindCost, so one search is shared by everyone who asks for the same goal.
+ */
+class TrueDistanceHeuristic : public Heuristic<Point>
+{
+protected:
+  Point goal;
+  Pathfinder<Point> reverseSearch;
+  bool isFinished = false;
+
+public:
+  TrueDistanceHeuristic(std::shared_ptr<GridMoves> inMoves, Point inGoal, uint32_t width, uint32_t height);
+
+  virtual bool IsCostFound(Point to) const override;
+
+  virtual Time GetCost(Point to) const override;
+
+  virtual void FindCost(Point to) override;
+
+  virtual Point GetOrigin() const override;
+
+  // Finishes the reverse search, afterwards the heuristic is read-only
+  void FindAllCosts();
+};
+
+struct DistanceTableKey
+{
+  Point goal;
+  Shape shape;
+
+  bool operator==(const DistanceTableKey& other) const
+  {
+    return goal == other.goal && shape == other.shape;
+  }
+};
+
+MAKE_HASHABLE(DistanceTableKey, type.goal, type.shape);
+
+/**
+ * Least recently used cache of true distance heuristics keyed by goal and agent shape.
+ * Agents with the same goal and shape share a heuristic, also between planning cycles.
+ * A heuristic evicted from the cache stays valid while somebody holds it.
+ * Use SpaceAdapter<Point, Area> to get a Heuristic<Area> from it.
+ */
+class HeuristicCache
+{
+protected:
+  struct CacheEntry
+  {
+    std::shared_ptr<TrueDistanceHeuristic> heuristic;
+    uint64_t lastUse;
+  };
+
+  std::shared_ptr<const RawSpace> space;
+  ArrayType<Move<Point>> moves;
+  size_t capacity;
+
+  MapType<DistanceTableKey, CacheEntry> entries;
+  uint64_t useCounter = 0;
+
+  void EvictLeastRecentlyUsed();
+
+public:
+  HeuristicCache(std::shared_ptr<const RawSpace> inSpace, const ArrayType<Move<Point>>& inMoves, size_t inCapacity);
+
+  std::shared_ptr<TrueDistanceHeuristic> Get(Point goal, const Shape& shape);
+
+  /**
+   * Gets heuristics for all keys and finishes their searches on the thread pool.
+   * Heuristics only depend on the static grid, so they can be computed before
+   * planning, while agents that share a key share one search.
+   */
+  ArrayType<std::shared_ptr<TrueDistanceHeuristic>> Precompute(const ArrayType<DistanceTableKey>& keys, ThreadPool& threadPool);
+
+  size_t Size() const;
+};
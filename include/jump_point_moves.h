@@ -0,0 +1,46 @@
+#pragma once
+
+#include "search_types.h"
+#include "space.h"
+#include "moves.h"
+#include <memory>
+
+/**
+ * Jump Point Search successors over a static 8-connected grid where diagonal moves
+ * don't cut corners (see EightConnectedNoCornerCuttingMoves). Symmetric paths are pruned:
+ * a node generates only jump points, and a move to a jump point costs its octile distance.
+ * Jumps stop at the goal, so Pathfinder<Point> with these moves finds the same cost of the goal
+ * as with plain moves, while intermediate cells of straight runs are never generated.
+ * Shaped agents use the map eroded by the shape, see ErodeByShape.
+ */
+class JumpPointMoves : public MoveComponent<Point>
+{
+protected:
+  std::shared_ptr<const RawSpace> space;
+  Point goal;
+
+  inline bool IsFree(int x, int y) const
+  {
+    Point point = { x, y };
+    return space->Contains(point) && space->GetAccess(point) == Access::Accessable;
+  }
+
+  // Returns false if there is no jump point in the direction from the cell
+  bool Jump(Point from, int dx, int dy, Point& jumpPoint) const;
+  bool JumpStraight(Point from, int dx, int dy, Point& jumpPoint) const;
+
+  // Scans rows word by word, 63 cells at a time
+  bool JumpHorizontal(Point from, int dx, Point& jumpPoint) const;
+
+  void AppendJump(Point from, int dx, int dy, ArrayType<Move<Point>>& validMoves) const;
+
+public:
+  JumpPointMoves(std::shared_ptr<const RawSpace> inSpace, Point inGoal);
+
+  void SetGoal(Point inGoal) { goal = inGoal; }
+
+  // Natural and forced neighbors are not known without a parent, so all jumps from the node are returned
+  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override;
+
+  virtual void AppendSuccessors(const Node<Point>& node, const Node<Point>* parent, ArrayType<Move<Point>>& validMoves) override;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "search_types.h"
+#include "space.h"
+#include "shapes.h"
+#include "moves.h"
+#include <array>
+#include <memory>
+#include <utility>
+
+#define DIAGONAL_MOVE_COST 1.41421356f
+
+/**
+ * Move of a compile-time move set. requiredNeighbors is a mask of neighbors
+ * (see RawSpace::NeighborOffsets) which must be accessable to make the move.
+ */
+struct GridMoveOffset
+{
+  int x;
+  int y;
+  Time cost;
+  uint8_t requiredNeighbors;
+};
+
+// Bit of the neighbor in RawSpace::GetAccessableNeighbors masks
+constexpr uint8_t NeighborMask(int x, int y)
+{
+  int index = (y + 1) * 3 + (x + 1);
+  return uint8_t(1) << (index > 4 ? index - 1 : index);
+}
+
+struct FourConnectedMoves
+{
+  static constexpr std::array<GridMoveOffset, 4> Moves =
+  { {
+    { 0, 1, 1, NeighborMask(0, 1) },
+    { 0, -1, 1, NeighborMask(0, -1) },
+    { 1, 0, 1, NeighborMask(1, 0) },
+    { -1, 0, 1, NeighborMask(-1, 0) },
+  } };
+};
+
+// Diagonal moves may cut corners of obstacles
+struct EightConnectedMoves
+{
+  static constexpr std::array<GridMoveOffset, 8> Moves =
+  { {
+    { 0, 1, 1, NeighborMask(0, 1) },
+    { 0, -1, 1, NeighborMask(0, -1) },
+    { 1, 0, 1, NeighborMask(1, 0) },
+    { -1, 0, 1, NeighborMask(-1, 0) },
+    { 1, 1, DIAGONAL_MOVE_COST, NeighborMask(1, 1) },
+    { -1, -1, DIAGONAL_MOVE_COST, NeighborMask(-1, -1) },
+    { 1, -1, DIAGONAL_MOVE_COST, NeighborMask(1, -1) },
+    { -1, 1, DIAGONAL_MOVE_COST, NeighborMask(-1, 1) },
+  } };
+};
+
+// Diagonal moves need both orthogonal neighbors next to them to be accessable
+struct EightConnectedNoCornerCuttingMoves
+{
+  static constexpr std::array<GridMoveOffset, 8> Moves =
+  { {
+    { 0, 1, 1, NeighborMask(0, 1) },
+    { 0, -1, 1, NeighborMask(0, -1) },
+    { 1, 0, 1, NeighborMask(1, 0) },
+    { -1, 0, 1, NeighborMask(-1, 0) },
+    { 1, 1, DIAGONAL_MOVE_COST, NeighborMask(1, 1) | NeighborMask(1, 0) | NeighborMask(0, 1) },
+    { -1, -1, DIAGONAL_MOVE_COST, NeighborMask(-1, -1) | NeighborMask(-1, 0) | NeighborMask(0, -1) },
+    { 1, -1, DIAGONAL_MOVE_COST, NeighborMask(1, -1) | NeighborMask(1, 0) | NeighborMask(0, -1) },
+    { -1, 1, DIAGONAL_MOVE_COST, NeighborMask(-1, 1) | NeighborMask(-1, 0) | NeighborMask(0, 1) },
+  } };
+};
+
+// Moves of the set for components which take them at runtime
+template<typename MoveSet>
+ArrayType<Move<Point>> MakeMoves()
+{
+  ArrayType<Move<Point>> moves;
+  for (const GridMoveOffset& move : MoveSet::Moves)
+  {
+    moves.push_back({ move.cost, Point{ move.x, move.y }, 0 });
+  }
+
+  return moves;
+}
+
+/**
+ * Moves over a static grid with a compile-time move set. Moves are unrolled
+ * and each validity check is a test of fixed bits of the accessable neighbors mask.
+ * Shape-aware moves use the map eroded by the shape, so the shape fits at the destination.
+ */
+template<typename MoveSet>
+class StaticGridMoves : public MoveComponent<Point>
+{
+protected:
+  std::shared_ptr<const RawSpace> space;
+
+  template<size_t Index>
+  inline void AppendMove(Point origin, uint8_t neighbors, ArrayType<Move<Point>>& validMoves) const
+  {
+    constexpr GridMoveOffset move = MoveSet::Moves[Index];
+    if ((neighbors & move.requiredNeighbors) == move.requiredNeighbors)
+    {
+      validMoves.push_back({ move.cost, Point{ origin.x + move.x, origin.y + move.y }, move.cost });
+    }
+  }
+
+  template<size_t... Indices>
+  inline void AppendMoves(Point origin, ArrayType<Move<Point>>& validMoves, std::index_sequence<Indices...>) const
+  {
+    uint8_t neighbors = space->GetAccessableNeighbors(origin);
+    (AppendMove<Indices>(origin, neighbors, validMoves), ...);
+  }
+
+public:
+  explicit StaticGridMoves(std::shared_ptr<const RawSpace> inSpace)
+    : space(inSpace)
+  { }
+
+  StaticGridMoves(const RawSpace& inSpace, const Shape& shape)
+    : space(std::make_shared<RawSpace>(ErodeByShape(inSpace, shape)))
+  { }
+
+  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override
+  {
+    ArrayType<Move<Point>> result;
+    AppendValidMoves(node, result);
+    return result;
+  }
+
+  virtual void AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& validMoves) override
+  {
+    AppendMoves(node.cell, validMoves, std::make_index_sequence<MoveSet::Moves.size()>());
+  }
+};
@@ -17,5 +17,24 @@ class MoveComponent
 public:
   virtual ArrayType<Move<CellType>> FindValidMoves(const Node<CellType>& node) = 0;
 
+  /**
+   * Appends valid moves to a buffer owned by the caller, so the buffer can be reused between calls.
+   * By default it copies the result of FindValidMoves; components override it to avoid allocations.
+   */
+  virtual void AppendValidMoves(const Node<CellType>& node, ArrayType<Move<CellType>>& validMoves)
+  {
+    ArrayType<Move<CellType>> found = FindValidMoves(node);
+    validMoves.insert(validMoves.end(), found.begin(), found.end());
+  }
+
+  /**
+   * Successors which may depend on the direction the node was reached from.
+   * Parent is nullptr for the origin. By default the direction is ignored.
+   */
+  virtual void AppendSuccessors(const Node<CellType>& node, const Node<CellType>*, ArrayType<Move<CellType>>& validMoves)
+  {
+    AppendValidMoves(node, validMoves);
+  }
+
   virtual ~MoveComponent() {};
 };
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "search_types.h"
+#include <algorithm>
+#include <cassert>
+
+/**
+ * Contiguous storage for nodes.
+ * Nodes are addressed by IDs which, unlike pointers, stay valid when the storage grows.
+ */
+template<typename CellType>
+class NodesArena
+{
+public:
+  using NodeType = Node<CellType>;
+
+protected:
+  ArrayType<NodeType> nodes;
+
+public:
+  NodeID Add(const NodeType& newNode);
+
+  inline NodeType& operator[](NodeID id)
+  {
+    assert(id < nodes.size());
+    return nodes[id];
+  }
+
+  inline const NodeType& operator[](NodeID id) const
+  {
+    assert(id < nodes.size());
+    return nodes[id];
+  }
+
+  size_t Size() const { return nodes.size(); }
+
+  // Nodes are trivially destructible, so clearing keeps the memory and costs O(1)
+  void Clear() { nodes.clear(); }
+};
+
+template<typename CellType>
+NodeID NodesArena<CellType>::Add(const NodeType& newNode)
+{
+  assert(nodes.size() < INVALID_NODE_ID);
+  nodes.push_back(newNode);
+  return (NodeID) (nodes.size() - 1);
+}
+
+// A generic lookup drops its entries when they outnumber the nodes of its largest search this many times
+#define NODES_LOOKUP_STALE_RATIO 8
+
+/**
+ * Maps cells to IDs of their nodes. Entries are stamped with a generation, so clearing is O(1):
+ * stale entries are ignored and overwritten when their cells are found again, which keeps the memory
+ * of the map for searches over the same cells. The map is only cleared when it grows much larger than searches need.
+ */
+template<typename CellType>
+class NodesLookup
+{
+protected:
+  struct Slot
+  {
+    NodeID id;
+    uint32_t generation;
+  };
+
+  MapType<CellType, Slot> ids;
+  uint32_t generation = 1;
+  // Entries of the current generation and the most of them since the map was cleared
+  size_t liveCount = 0;
+  size_t maxLiveCount = 0;
+
+public:
+  // Only grid cells can use bounds, other cell types ignore them
+  void SetBounds(uint32_t, uint32_t) { }
+
+  NodeID Find(const CellType& cell) const
+  {
+    auto found = ids.find(cell);
+    return found == ids.end() || found->second.generation != generation ? INVALID_NODE_ID : found->second.id;
+  }
+
+  void Set(const CellType& cell, NodeID id)
+  {
+    Slot& slot = ids[cell];
+    if (slot.generation != generation) liveCount++;
+    slot = { id, generation };
+  }
+
+  void Clear()
+  {
+    maxLiveCount = std::max(maxLiveCount, liveCount);
+    liveCount = 0;
+
+    // New slots are value-initialized with generation 0, so it is never current
+    if (++generation == 0 || ids.size() > (maxLiveCount + 1) * NODES_LOOKUP_STALE_RATIO)
+    {
+      ids.clear();
+      generation = 1;
+      maxLiveCount = 0;
+    }
+  }
+};
+
+/**
+ * Points inside of the bounds are mapped to IDs by a dense row-major array,
+ * so the lookup is an array index. Points outside of the bounds fall back to a hash map.
+ * Dense slots are stamped with a generation, so clearing them is O(1).
+ */
+template<>
+class NodesLookup<Point>
+{
+protected:
+  struct Slot
+  {
+    NodeID id;
+    uint32_t generation;
+  };
+
+  ArrayType<Slot> denseIds;
+  MapType<Point, NodeID> sparseIds;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t generation = 1;
+
+  inline bool IsDense(const Point& point) const
+  {
+    return point.x >= 0 && (uint32_t) point.x < width && point.y >= 0 && (uint32_t) point.y < height;
+  }
+
+  inline size_t PointToIndex(const Point& point) const
+  {
+    return point.x + (size_t) point.y * width;
+  }
+
+public:
+  void SetBounds(uint32_t inWidth, uint32_t inHeight)
+  {
+    MapType<Point, NodeID> oldIds;
+    oldIds.swap(sparseIds);
+    for (int x = 0; x < (int) width; ++x)
+    {
+      for (int y = 0; y < (int) height; ++y)
+      {
+        NodeID id = Find({ x, y });
+        if (id != INVALID_NODE_ID) oldIds[{ x, y }] = id;
+      }
+    }
+
+    width = inWidth;
+    height = inHeight;
+    generation = 1;
+    denseIds.assign((size_t) width * height, Slot{ INVALID_NODE_ID, 0 });
+
+    for (const auto& [point, id] : oldIds)
+    {
+      Set(point, id);
+    }
+  }
+
+  NodeID Find(const Point& point) const
+  {
+    if (IsDense(point))
+    {
+      const Slot& slot = denseIds[PointToIndex(point)];
+      return slot.generation == generation ? slot.id : INVALID_NODE_ID;
+    }
+
+    auto found = sparseIds.find(point);
+    return found == sparseIds.end() ? INVALID_NODE_ID : found->second;
+  }
+
+  void Set(const Point& point, NodeID id)
+  {
+    if (IsDense(point))
+    {
+      denseIds[PointToIndex(point)] = { id, generation };
+      return;
+    }
+
+    sparseIds[point] = id;
+  }
+
+  void Clear()
+  {
+    if (++generation == 0)
+    {
+      // Stamps have wrapped around, so old slots could look valid
+      std::fill(denseIds.begin(), denseIds.end(), Slot{ INVALID_NODE_ID, 0 });
+      generation = 1;
+    }
+
+    sparseIds.clear();
+  }
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "search_types.h"
+#include "nodes_arena.h"
+#include "segments.h"
+#include <algorithm>
 #include <cassert>
 
 #define HEAP_START_CAPACITY 16
@@ -13,38 +16,57 @@ class NodesBinaryHeap
 {
 public:
   using NodeType = Node<CellType>;
+  using ArenaType = NodesArena<CellType>;
 
 protected:
-  // TODO not NodeType* but size_t, node can be moved in dynamic memory 
-  // so we need to store ID, not pointer
-  ArrayType<NodeType*> nodes;
+  // IDs of nodes stored in the arena, the first element is unused
+  ArrayType<NodeID> nodes;
+  ArenaType& arena;
 
   // TODO create NodesBinaryHeap.config
   bool isTieBreakMaxTime;
 
+  size_t pushesCount = 0;
+  size_t popsCount = 0;
+
   void MoveUp(size_t nodeIndex);
   void MoveDown(size_t nodeIndex);
 
 public:
   NodesBinaryHeap() = delete;
-  NodesBinaryHeap(bool inIsTieBreakMaxTime);
+  NodesBinaryHeap(bool inIsTieBreakMaxTime, ArenaType& inArena);
 
   // Returns true if the first node is greater than the second one
   bool Compare(const NodeType& first, const NodeType& second) const;
 
-  NodeType* PopMin();
+  // Returns INVALID_NODE_ID if the heap is empty
+  NodeID PopMin();
+
+  void Insert(NodeID newNode);
 
-  void Insert(NodeType& newNode);
+  void ImproveTime(NodeID changedNode, Time newMinTime);
 
-  void ImproveTime(NodeType& changedNode, Time newMinTime);
+  // Returns INVALID_NODE_ID if the heap is empty
+  NodeID Top() const { return Size() ? nodes[1] : INVALID_NODE_ID; }
+
+  // Removes a node which is in the heap
+  void Remove(NodeID removedNode);
 
   size_t Size() const;
+
+  // Entries pushed and popped since Reset, ImproveTime moves an entry in place
+  size_t GetPushesCount() const { return pushesCount; }
+  size_t GetPopsCount() const { return popsCount; }
+
+  // Removes all nodes, keeping the allocated memory
+  void Reset();
 };
 
 template<typename CellType>
-NodesBinaryHeap<CellType>::NodesBinaryHeap(bool inIsTieBreakMaxTime)
-  : isTieBreakMaxTime(inIsTieBreakMaxTime)
-  , nodes{ nullptr }
+NodesBinaryHeap<CellType>::NodesBinaryHeap(bool inIsTieBreakMaxTime, ArenaType& inArena)
+  : nodes{ INVALID_NODE_ID }
+  , arena(inArena)
+  , isTieBreakMaxTime(inIsTieBreakMaxTime)
 {
   nodes.reserve(HEAP_START_CAPACITY);
 }
@@ -53,10 +75,10 @@ template<typename CellType>
 void NodesBinaryHeap<CellType>::MoveUp(size_t nodeIndex)
 {
   for (size_t parentIndex = (nodeIndex >> 1);
-    parentIndex && Compare(*nodes[parentIndex], *nodes[nodeIndex]);
+    parentIndex && Compare(arena[nodes[parentIndex]], arena[nodes[nodeIndex]]);
     nodeIndex >>= 1, parentIndex >>= 1)
   {
-    std::swap(nodes[parentIndex]->heapIndex, nodes[nodeIndex]->heapIndex);
+    std::swap(arena[nodes[parentIndex]].heapIndex, arena[nodes[nodeIndex]].heapIndex);
     std::swap(nodes[parentIndex], nodes[nodeIndex]);
   }
 }
@@ -66,13 +88,13 @@ void NodesBinaryHeap<CellType>::MoveDown(size_t nodeIndex)
 {
   for (size_t minChildIndex = nodeIndex << 1; minChildIndex < nodes.size(); minChildIndex = nodeIndex << 1)
   {
-    if (minChildIndex + 1 < nodes.size() && Compare(*nodes[minChildIndex], *nodes[minChildIndex + 1]))
+    if (minChildIndex + 1 < nodes.size() && Compare(arena[nodes[minChildIndex]], arena[nodes[minChildIndex + 1]]))
     {
       ++minChildIndex;
     }
 
-    NodeType& currentNode = *nodes[nodeIndex];
-    NodeType& minChild = *nodes[minChildIndex];
+    NodeType& currentNode = arena[nodes[nodeIndex]];
+    NodeType& minChild = arena[nodes[minChildIndex]];
     if (!Compare(currentNode, minChild))
     {
       return;
@@ -85,41 +107,70 @@ void NodesBinaryHeap<CellType>::MoveDown(size_t nodeIndex)
 }
 
 template<typename CellType>
-void NodesBinaryHeap<CellType>::Insert(NodeType& newNode)
+void NodesBinaryHeap<CellType>::Insert(NodeID newNode)
 {
-  newNode.heapIndex = nodes.size();
-  nodes.emplace_back(&newNode);
-  MoveUp(newNode.heapIndex);
+  ++pushesCount;
+  arena[newNode].heapIndex = (uint32_t) nodes.size();
+  nodes.emplace_back(newNode);
+  MoveUp(nodes.size() - 1);
 }
 
 template<typename CellType>
-void NodesBinaryHeap<CellType>::ImproveTime(NodeType& changedNode, Time newMinTime)
+void NodesBinaryHeap<CellType>::ImproveTime(NodeID changedNode, Time newMinTime)
 {
-  changedNode.minTime = newMinTime;
-  MoveUp(changedNode.heapIndex);
+  arena[changedNode].minTime = newMinTime;
+  MoveUp(arena[changedNode].heapIndex);
 }
 
 template<typename CellType>
-Node<CellType>* NodesBinaryHeap<CellType>::PopMin()
+NodeID NodesBinaryHeap<CellType>::PopMin()
 {
   if (Size() == 0)
   {
-    return nullptr;
+    return INVALID_NODE_ID;
   }
 
-  NodeType* result = nodes[1];
+  ++popsCount;
+  NodeID result = nodes[1];
   std::swap(nodes[1], nodes.back());
   nodes.pop_back();
 
   if (Size() > 0)
   {
-    nodes[1]->heapIndex = 1;
+    arena[nodes[1]].heapIndex = 1;
     MoveDown(1);
   }
 
   return result;
 }
 
+template<typename CellType>
+void NodesBinaryHeap<CellType>::Remove(NodeID removedNode)
+{
+  size_t nodeIndex = arena[removedNode].heapIndex;
+  assert(nodeIndex < nodes.size() && nodes[nodeIndex] == removedNode);
+  ++popsCount;
+
+  NodeID movedNode = nodes.back();
+  nodes[nodeIndex] = movedNode;
+  nodes.pop_back();
+
+  if (nodeIndex < nodes.size())
+  {
+    arena[movedNode].heapIndex = (uint32_t) nodeIndex;
+    MoveUp(nodeIndex);
+    MoveDown(arena[movedNode].heapIndex);
+  }
+}
+
+template<typename CellType>
+void NodesBinaryHeap<CellType>::Reset()
+{
+  nodes.resize(1);
+  pushesCount = 0;
+  popsCount = 0;
+}
+
 template<typename CellType>
 size_t NodesBinaryHeap<CellType>::Size() const
 {
@@ -140,3 +191,552 @@ bool NodesBinaryHeap<CellType>::Compare(const NodeType& first, const NodeType& s
 
   return firstFullTime > secondFullTime;
 }
+
+/**
+ * Min d-ary heap for nodes, a drop-in alternative to NodesBinaryHeap.
+ * Priorities are stored inline next to node IDs, so sifting doesn't access the arena.
+ */
+template<typename CellType, size_t Arity = 4>
+class NodesDaryHeap
+{
+  static_assert(Arity >= 2, "NodesDaryHeap: arity must be at least 2");
+
+public:
+  using NodeType = Node<CellType>;
+  using ArenaType = NodesArena<CellType>;
+
+protected:
+  struct HeapEntry
+  {
+    Time fullTime;
+    Time minTime;
+    NodeID node;
+  };
+
+  ArrayType<HeapEntry> entries;
+  ArenaType& arena;
+
+  bool isTieBreakMaxTime;
+
+  size_t pushesCount = 0;
+  size_t popsCount = 0;
+
+  void MoveUp(size_t entryIndex);
+  void MoveDown(size_t entryIndex);
+
+  inline void Place(size_t entryIndex, const HeapEntry& entry)
+  {
+    entries[entryIndex] = entry;
+    arena[entry.node].heapIndex = (uint32_t) entryIndex;
+  }
+
+public:
+  NodesDaryHeap() = delete;
+  NodesDaryHeap(bool inIsTieBreakMaxTime, ArenaType& inArena);
+
+  // Returns true if the first entry is greater than the second one
+  inline bool Compare(const HeapEntry& first, const HeapEntry& second) const
+  {
+    if (first.fullTime == second.fullTime)
+    {
+      return isTieBreakMaxTime == (first.minTime < second.minTime);
+    }
+
+    return first.fullTime > second.fullTime;
+  }
+
+  // Returns INVALID_NODE_ID if the heap is empty
+  NodeID PopMin();
+
+  void Insert(NodeID newNode);
+
+  void ImproveTime(NodeID changedNode, Time newMinTime);
+
+  size_t Size() const { return entries.size(); }
+
+  // Entries pushed and popped since Reset, ImproveTime moves an entry in place
+  size_t GetPushesCount() const { return pushesCount; }
+  size_t GetPopsCount() const { return popsCount; }
+
+  // Removes all nodes, keeping the allocated memory
+  void Reset()
+  {
+    entries.clear();
+    pushesCount = 0;
+    popsCount = 0;
+  }
+};
+
+template<typename CellType, size_t Arity>
+NodesDaryHeap<CellType, Arity>::NodesDaryHeap(bool inIsTieBreakMaxTime, ArenaType& inArena)
+  : entries()
+  , arena(inArena)
+  , isTieBreakMaxTime(inIsTieBreakMaxTime)
+{
+  entries.reserve(HEAP_START_CAPACITY);
+}
+
+template<typename CellType, size_t Arity>
+void NodesDaryHeap<CellType, Arity>::MoveUp(size_t entryIndex)
+{
+  HeapEntry movedEntry = entries[entryIndex];
+
+  while (entryIndex > 0)
+  {
+    size_t parentIndex = (entryIndex - 1) / Arity;
+    if (!Compare(entries[parentIndex], movedEntry))
+    {
+      break;
+    }
+
+    Place(entryIndex, entries[parentIndex]);
+    entryIndex = parentIndex;
+  }
+
+  Place(entryIndex, movedEntry);
+}
+
+template<typename CellType, size_t Arity>
+void NodesDaryHeap<CellType, Arity>::MoveDown(size_t entryIndex)
+{
+  HeapEntry movedEntry = entries[entryIndex];
+
+  for (size_t firstChild = entryIndex * Arity + 1; firstChild < entries.size(); firstChild = entryIndex * Arity + 1)
+  {
+    size_t lastChild = std::min(firstChild + Arity, entries.size());
+    size_t minChildIndex = firstChild;
+    for (size_t childIndex = firstChild + 1; childIndex < lastChild; ++childIndex)
+    {
+      if (Compare(entries[minChildIndex], entries[childIndex]))
+      {
+        minChildIndex = childIndex;
+      }
+    }
+
+    if (!Compare(movedEntry, entries[minChildIndex]))
+    {
+      break;
+    }
+
+    Place(entryIndex, entries[minChildIndex]);
+    entryIndex = minChildIndex;
+  }
+
+  Place(entryIndex, movedEntry);
+}
+
+template<typename CellType, size_t Arity>
+void NodesDaryHeap<CellType, Arity>::Insert(NodeID newNode)
+{
+  ++pushesCount;
+  const NodeType& node = arena[newNode];
+  entries.push_back({ node.minTime + node.heursticToGoal, node.minTime, newNode });
+  MoveUp(entries.size() - 1);
+}
+
+template<typename CellType, size_t Arity>
+void NodesDaryHeap<CellType, Arity>::ImproveTime(NodeID changedNode, Time newMinTime)
+{
+  NodeType& node = arena[changedNode];
+  node.minTime = newMinTime;
+
+  HeapEntry& entry = entries[node.heapIndex];
+  assert(entry.node == changedNode);
+  entry.minTime = newMinTime;
+  entry.fullTime = newMinTime + node.heursticToGoal;
+  MoveUp(node.heapIndex);
+}
+
+template<typename CellType, size_t Arity>
+NodeID NodesDaryHeap<CellType, Arity>::PopMin()
+{
+  if (Size() == 0)
+  {
+    return INVALID_NODE_ID;
+  }
+
+  ++popsCount;
+  NodeID result = entries.front().node;
+  entries.front() = entries.back();
+  entries.pop_back();
+
+  if (Size() > 0)
+  {
+    MoveDown(0);
+  }
+
+  return result;
+}
+
+/**
+ * Bucketed queue for nodes, a drop-in alternative to NodesBinaryHeap for searches
+ * with few distinct f-values (unit and octile costs).
+ * Nodes are put into buckets by f-value quantized with BucketsPerUnit buckets per time unit.
+ * Each bucket is a small heap ordered by the exact f-value and the tie-break,
+ * so the order of popped nodes is the same as in NodesBinaryHeap.
+ * ImproveTime reinserts a node and its old entry is skipped when it is popped.
+ */
+template<typename CellType, uint32_t BucketsPerUnit = 64>
+class NodesBucketQueue
+{
+  static_assert(BucketsPerUnit > 0, "NodesBucketQueue: at least one bucket per time unit is needed");
+
+public:
+  using NodeType = Node<CellType>;
+  using ArenaType = NodesArena<CellType>;
+
+protected:
+  struct BucketEntry
+  {
+    Time fullTime;
+    Time minTime;
+    NodeID node;
+  };
+
+  ArrayType<ArrayType<BucketEntry>> buckets;
+  ArenaType& arena;
+
+  // All buckets before the current one are empty
+  size_t currentBucket;
+  size_t nodesCount;
+
+  size_t pushesCount = 0;
+  size_t popsCount = 0;
+
+  bool isTieBreakMaxTime;
+
+  void Push(const BucketEntry& entry);
+
+public:
+  NodesBucketQueue() = delete;
+  NodesBucketQueue(bool inIsTieBreakMaxTime, ArenaType& inArena);
+
+  // Returns true if the first entry is greater than the second one
+  inline bool Compare(const BucketEntry& first, const BucketEntry& second) const
+  {
+    if (first.fullTime == second.fullTime)
+    {
+      return isTieBreakMaxTime ? first.minTime < second.minTime : first.minTime > second.minTime;
+    }
+
+    return first.fullTime > second.fullTime;
+  }
+
+  // Returns INVALID_NODE_ID if the queue is empty
+  NodeID PopMin();
+
+  void Insert(NodeID newNode);
+
+  void ImproveTime(NodeID changedNode, Time newMinTime);
+
+  size_t Size() const { return nodesCount; }
+
+  // Entries pushed and popped since Reset, outdated entries included
+  size_t GetPushesCount() const { return pushesCount; }
+  size_t GetPopsCount() const { return popsCount; }
+
+  // Removes all nodes, keeping the allocated memory
+  void Reset();
+};
+
+template<typename CellType, uint32_t BucketsPerUnit>
+NodesBucketQueue<CellType, BucketsPerUnit>::NodesBucketQueue(bool inIsTieBreakMaxTime, ArenaType& inArena)
+  : buckets()
+  , arena(inArena)
+  , currentBucket(0)
+  , nodesCount(0)
+  , isTieBreakMaxTime(inIsTieBreakMaxTime)
+{
+  buckets.reserve(HEAP_START_CAPACITY);
+}
+
+template<typename CellType, uint32_t BucketsPerUnit>
+void NodesBucketQueue<CellType, BucketsPerUnit>::Push(const BucketEntry& entry)
+{
+  assert(entry.fullTime >= 0);
+  ++pushesCount;
+
+  size_t bucketIndex = (size_t) (entry.fullTime * BucketsPerUnit);
+  if (bucketIndex >= buckets.size())
+  {
+    buckets.resize(bucketIndex + 1);
+  }
+
+  ArrayType<BucketEntry>& bucket = buckets[bucketIndex];
+  bucket.push_back(entry);
+  std::push_heap(bucket.begin(), bucket.end(),
+    [this](const BucketEntry& first, const BucketEntry& second) { return Compare(first, second); });
+
+  currentBucket = std::min(currentBucket, bucketIndex);
+}
+
+template<typename CellType, uint32_t BucketsPerUnit>
+void NodesBucketQueue<CellType, BucketsPerUnit>::Insert(NodeID newNode)
+{
+  const NodeType& node = arena[newNode];
+  Push({ node.minTime + node.heursticToGoal, node.minTime, newNode });
+  ++nodesCount;
+}
+
+template<typename CellType, uint32_t BucketsPerUnit>
+void NodesBucketQueue<CellType, BucketsPerUnit>::ImproveTime(NodeID changedNode, Time newMinTime)
+{
+  NodeType& node = arena[changedNode];
+  assert(newMinTime < node.minTime);
+  node.minTime = newMinTime;
+
+  // The old entry stays in its bucket, it is recognised as outdated by its time
+  Push({ newMinTime + node.heursticToGoal, newMinTime, changedNode });
+}
+
+template<typename CellType, uint32_t BucketsPerUnit>
+NodeID NodesBucketQueue<CellType, BucketsPerUnit>::PopMin()
+{
+  while (nodesCount > 0)
+  {
+    while (buckets[currentBucket].empty())
+    {
+      ++currentBucket;
+    }
+
+    ArrayType<BucketEntry>& bucket = buckets[currentBucket];
+    std::pop_heap(bucket.begin(), bucket.end(),
+      [this](const BucketEntry& first, const BucketEntry& second) { return Compare(first, second); });
+    BucketEntry entry = bucket.back();
+    bucket.pop_back();
+    ++popsCount;
+
+    if (arena[entry.node].minTime != entry.minTime)
+    {
+      continue;
+    }
+
+    --nodesCount;
+    return entry.node;
+  }
+
+  return INVALID_NODE_ID;
+}
+
+template<typename CellType, uint32_t BucketsPerUnit>
+void NodesBucketQueue<CellType, BucketsPerUnit>::Reset()
+{
+  // Outdated entries may remain in any bucket after the current one
+  for (size_t bucketIndex = currentBucket; bucketIndex < buckets.size(); ++bucketIndex)
+  {
+    buckets[bucketIndex].clear();
+  }
+
+  currentBucket = 0;
+  nodesCount = 0;
+  pushesCount = 0;
+  popsCount = 0;
+}
+
+/**
+ * Secondary criterion of NodesFocalList: the heuristic distance to the goal,
+ * so nodes which are closer to the goal are expanded first.
+ */
+template<typename CellType>
+struct FocalByHeuristic
+{
+  inline Time operator()(const Node<CellType>& node) const { return node.heursticToGoal; }
+};
+
+/**
+ * Secondary criterion of NodesFocalList for searches over safe intervals (Node<Area>): nodes which
+ * stay free longer are expanded first, so nodes which must be left before a reservation of another
+ * agent are deferred. Nodes free until the end of the window tie and are expanded by f.
+ */
+struct FocalByIntervalEnd
+{
+  inline Time operator()(const Node<Area>& node) const { return -node.cell.interval.end; }
+};
+
+/**
+ * Open list for bounded-suboptimal focal search, a drop-in alternative to NodesBinaryHeap.
+ * Nodes with f <= bound * min f form the focal list, and the node with the least
+ * secondary criterion among them is popped, so the cost of a settled node is at most
+ * bound times the optimal cost. With bound = 1 it pops nodes with the least f.
+ *
+ * Nodes are kept in a NodesBinaryHeap by f, which tracks min f. Entries of nodes with f above
+ * the bound wait in a heap by f until the bound reaches them. ImproveTime pushes a new entry
+ * and outdated entries are skipped when they are popped.
+ */
+template<typename CellType, typename FocalCriterion = FocalByHeuristic<CellType>>
+class NodesFocalList
+{
+public:
+  using NodeType = Node<CellType>;
+  using ArenaType = NodesArena<CellType>;
+
+protected:
+  struct FocalEntry
+  {
+    Time criterion;
+    Time fullTime;
+    Time minTime;
+    NodeID node;
+  };
+
+  NodesBinaryHeap<CellType> openNodes;
+  ArrayType<FocalEntry> focal;
+  ArrayType<FocalEntry> waiting;
+  ArenaType& arena;
+
+  FocalCriterion criterion;
+  Time bound = 1;
+
+  size_t pushesCount = 0;
+  size_t popsCount = 0;
+
+  inline bool IsOutdated(const FocalEntry& entry) const
+  {
+    const NodeType& node = arena[entry.node];
+    return node.heursticToGoal < 0 || node.minTime != entry.minTime;
+  }
+
+  // Heap comparators return true if the first entry is popped after the second one
+  static bool CompareFocal(const FocalEntry& first, const FocalEntry& second)
+  {
+    if (first.criterion == second.criterion)
+    {
+      return first.fullTime > second.fullTime;
+    }
+
+    return first.criterion > second.criterion;
+  }
+
+  static bool CompareWaiting(const FocalEntry& first, const FocalEntry& second)
+  {
+    return first.fullTime > second.fullTime;
+  }
+
+  void Push(NodeID node);
+
+public:
+  NodesFocalList() = delete;
+  NodesFocalList(bool inIsTieBreakMaxTime, ArenaType& inArena);
+
+  void SetSuboptimalityBound(Time inBound);
+
+  // Returns INVALID_NODE_ID if the list is empty
+  NodeID PopMin();
+
+  void Insert(NodeID newNode);
+
+  void ImproveTime(NodeID changedNode, Time newMinTime);
+
+  size_t Size() const { return openNodes.Size(); }
+
+  // Entries pushed and popped since Reset, outdated entries included
+  size_t GetPushesCount() const { return pushesCount; }
+  size_t GetPopsCount() const { return popsCount; }
+
+  void Reset();
+};
+
+template<typename CellType, typename FocalCriterion>
+NodesFocalList<CellType, FocalCriterion>::NodesFocalList(bool inIsTieBreakMaxTime, ArenaType& inArena)
+  : openNodes(inIsTieBreakMaxTime, inArena)
+  , arena(inArena)
+{ }
+
+template<typename CellType, typename FocalCriterion>
+void NodesFocalList<CellType, FocalCriterion>::SetSuboptimalityBound(Time inBound)
+{
+  assert(inBound >= 1);
+  bound = inBound;
+}
+
+template<typename CellType, typename FocalCriterion>
+void NodesFocalList<CellType, FocalCriterion>::Push(NodeID node)
+{
+  ++pushesCount;
+  const NodeType& pushedNode = arena[node];
+  waiting.push_back({ criterion(pushedNode), pushedNode.minTime + pushedNode.heursticToGoal, pushedNode.minTime, node });
+  std::push_heap(waiting.begin(), waiting.end(), CompareWaiting);
+}
+
+template<typename CellType, typename FocalCriterion>
+void NodesFocalList<CellType, FocalCriterion>::Insert(NodeID newNode)
+{
+  openNodes.Insert(newNode);
+  Push(newNode);
+}
+
+template<typename CellType, typename FocalCriterion>
+void NodesFocalList<CellType, FocalCriterion>::ImproveTime(NodeID changedNode, Time newMinTime)
+{
+  openNodes.ImproveTime(changedNode, newMinTime);
+  Push(changedNode);
+}
+
+template<typename CellType, typename FocalCriterion>
+NodeID NodesFocalList<CellType, FocalCriterion>::PopMin()
+{
+  NodeID minNode = openNodes.Top();
+  if (minNode == INVALID_NODE_ID)
+  {
+    return INVALID_NODE_ID;
+  }
+
+  const Time focalTime = bound * (arena[minNode].minTime + arena[minNode].heursticToGoal);
+
+  // Entries reached by the bound join the focal list, the entry of the min node is always among them
+  while (!waiting.empty() && waiting.front().fullTime <= focalTime)
+  {
+    std::pop_heap(waiting.begin(), waiting.end(), CompareWaiting);
+    FocalEntry entry = waiting.back();
+    waiting.pop_back();
+
+    if (IsOutdated(entry))
+    {
+      ++popsCount;
+      continue;
+    }
+
+    focal.push_back(entry);
+    std::push_heap(focal.begin(), focal.end(), CompareFocal);
+  }
+
+  while (!focal.empty())
+  {
+    std::pop_heap(focal.begin(), focal.end(), CompareFocal);
+    FocalEntry entry = focal.back();
+    focal.pop_back();
+
+    if (IsOutdated(entry))
+    {
+      ++popsCount;
+      continue;
+    }
+
+    // Min f can decrease after ImproveTime, so the entry may be above the bound again
+    if (entry.fullTime > focalTime)
+    {
+      waiting.push_back(entry);
+      std::push_heap(waiting.begin(), waiting.end(), CompareWaiting);
+      continue;
+    }
+
+    ++popsCount;
+    openNodes.Remove(entry.node);
+    return entry.node;
+  }
+
+  assert(false && "NodesFocalList: the min node must be in the focal list");
+  ++popsCount;
+  openNodes.Remove(minNode);
+  return minNode;
+}
+
+template<typename CellType, typename FocalCriterion>
+void NodesFocalList<CellType, FocalCriterion>::Reset()
+{
+  openNodes.Reset();
+  focal.clear();
+  waiting.clear();
+  pushesCount = 0;
+  popsCount = 0;
+}
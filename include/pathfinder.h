@@ -1,48 +1,24 @@
 #pragma once
 
 #include "nodes_heap.h"
+#include "nodes_arena.h"
 #include "heuristic.h"
 #include "search_types.h"
 #include "moves.h"
-#include <chrono>
+#include "search_result.h"
 #include <cassert>
-
-template<typename CellType>
-class SearchResult
-{
-private:
-  std::chrono::steady_clock::time_point timer_start = std::chrono::high_resolution_clock::now();
-
-  double time = 0;
-  size_t nodescreated = 0;
-  size_t numberofsteps = 0;
-
-public:
-  inline void IncrementSteps()
-  {
-    numberofsteps++;
-  }
-
-  inline void SetNodesCount(size_t inNodesCount)
-  {
-    nodescreated = inNodesCount;
-  }
-
-  inline void StartTimer()
-  {
-    timer_start = std::chrono::high_resolution_clock::now();
-  }
-
-  inline void StopTimer()
-  {
-    // TODO create timer object which incapsulates duration count like shared pointer
-
-    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - timer_start;
-    time += duration.count(); // in seconds
-  }
-};
-
-template<typename CellType>
+#include <algorithm>
+#include <limits>
+
+// Cost of targets which FindCosts hasn't settled
+#define UNREACHED_COST -1
+
+/**
+ * OpenListType is a min heap of node IDs: NodesBinaryHeap, NodesDaryHeap, NodesBucketQueue or any type with
+ * the same constructor (tie-break flag, arena), Insert, ImproveTime, PopMin, Size, Reset,
+ * GetPushesCount and GetPopsCount.
+ */
+template<typename CellType, typename OpenListType = NodesBinaryHeap<CellType>>
 class Pathfinder : public Heuristic<CellType>
 {
 protected:
@@ -51,16 +27,36 @@ protected:
 
   mutable StatType statistics;
 
-  NodesBinaryHeap<CellType> openNodes;
-  MapType<CellType, NodeType> nodes;
+  // The heap refers to the arena, so the arena is declared first
+  NodesArena<CellType> nodes;
+  NodesLookup<CellType> nodeIds;
+  OpenListType openNodes;
 
   std::shared_ptr<Heuristic<CellType>> heuristic;
   std::shared_ptr<MoveComponent<CellType>> moves;
 
-  virtual void TryToStopSearch(const NodeType& node, CellType searchDestination) {};
+  Time heuristicWeight = 1;
+
+  // Successors which cost with the heuristic isn't lower are not created
+  Time pruningCost = std::numeric_limits<Time>::max();
+
+  // Reused by every expansion, so successors don't allocate in steady state
+  ArrayType<Move<CellType>> validMoves;
+
+  // Indices of the targets of FindCosts, looked up like nodes
+  NodesLookup<CellType> targetIds;
+
+  virtual void TryToStopSearch(NodeID node, CellType searchDestination) {};
 
 protected:
-  void ExpandNode(NodeType& node);
+  void AddOrigin(CellType origin);
+  void ExpandNode(NodeID node);
+
+  // Pops the best open node, closes and expands it
+  NodeID ExpandMin();
+
+  // Stops the search timer and takes the counters of the arena and the open list
+  void StopTimer();
 
 public:
   Pathfinder(
@@ -68,27 +64,70 @@ public:
     CellType origin,
     std::shared_ptr<Heuristic<CellType>> inHeuristic);
 
+  Pathfinder(const Pathfinder&) = delete;
+
+  /**
+   * If cells are points of a grid with known size, nodes are looked up by
+   * array index instead of hashing. Other cell types ignore the bounds.
+   */
+  void SetGridBounds(uint32_t width, uint32_t height);
+
+  /**
+   * Starts a new search from the origin, reusing memory of the previous one.
+   * Found costs, nodes and statistics of the previous search are discarded.
+   */
+  void Reset(CellType origin);
+  void Reset(CellType origin, std::shared_ptr<Heuristic<CellType>> inHeuristic);
+
+  /**
+   * Weighted A*: heuristic costs of new nodes are multiplied by the weight,
+   * so settled costs are at most weight times the optimal ones. Kept after Reset.
+   */
+  void SetHeuristicWeight(Time weight);
+
+  // Only for open lists with a bound, see NodesFocalList. Kept after Reset
+  void SetSuboptimalityBound(Time bound) { openNodes.SetSuboptimalityBound(bound); }
+
   virtual bool IsCostFound(CellType to) const override;
   virtual Time GetCost(CellType to) const override;
   virtual void FindCost(CellType to) override;
 
-  StatType GetStats() const { return statistics; }
+  /**
+   * A cost is found when a node for the cell is created, but it may still improve.
+   * A cost is settled when the node is expanded, so with a consistent heuristic it's exact.
+   */
+  bool IsCostSettled(CellType to) const;
+  void SettleCost(CellType to);
+
+  // Expands nodes until the open list is empty, so every reachable cost is settled
+  void SettleAll();
+
+  /**
+   * One-to-many search: continues the search until every target is settled or the cost
+   * of expanded nodes exceeds the bound. costs[i] is the settled cost of targets[i] or UNREACHED_COST.
+   * The heuristic must not overestimate the cost to any of the targets (for example, the zero Heuristic).
+   * If paths are given, paths[i] is the path to targets[i] or an empty path.
+   */
+  void FindCosts(const ArrayType<CellType>& targets, ArrayType<Time>& costs,
+    Time bound = std::numeric_limits<Time>::max(), ArrayType<ArrayType<NodeType>>* paths = nullptr);
+
+  const StatType& GetStats() const { return statistics; }
 
   void CollectPath(CellType to, ArrayType<NodeType>& path) const;
 };
 
-template<typename CellType>
-class WindowedPathfinder : public Pathfinder<CellType>
+template<typename CellType, typename OpenListType = NodesBinaryHeap<CellType>>
+class WindowedPathfinder : public Pathfinder<CellType, OpenListType>
 {
 protected:
   Time depth;
 
 protected:
-  virtual void TryToStopSearch(const NodeType& node, CellType searchDestination) override
+  virtual void TryToStopSearch(NodeID node, CellType searchDestination) override
   {
-    if (node.minTime >= depth)
+    if (this->nodes[node].minTime >= depth)
     {
-      nodes[searchDestination] = node;
+      this->nodeIds.Set(searchDestination, node);
     }
   }
 
@@ -99,23 +138,23 @@ public:
     , std::shared_ptr<Heuristic<CellType>> inHeuristic
     , Time inDepth
   )
-    : Pathfinder(inMoves, origin, inHeuristic)
+    : Pathfinder<CellType, OpenListType>(inMoves, origin, inHeuristic)
     , depth(inDepth)
   {
     assert(depth > 0);
   }
 };
 
-template<typename CellType>
-Pathfinder<CellType>::Pathfinder(
+template<typename CellType, typename OpenListType>
+Pathfinder<CellType, OpenListType>::Pathfinder(
   std::shared_ptr<MoveComponent<CellType>> inMoves, 
   CellType origin,
   std::shared_ptr<Heuristic<CellType>> inHeuristic
   )
-  : Heuristic(origin)
-  , moves(inMoves)
-  , openNodes(true)
+  : Heuristic<CellType>(origin)
+  , openNodes(true, nodes)
   , heuristic(inHeuristic)
+  , moves(inMoves)
 {
   /*
   heuristic->FindCost(origin);
@@ -124,95 +163,245 @@ Pathfinder<CellType>::Pathfinder(
     
   }*/
 
-  nodes[origin] = Node<CellType>(origin, Time(0), 0);
-  openNodes.Insert(nodes[origin]);
+  AddOrigin(origin);
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::AddOrigin(CellType origin)
+{
+  NodeID originNode = nodes.Add(Node<CellType>(origin, Time(0), 0));
+  nodeIds.Set(origin, originNode);
+  openNodes.Insert(originNode);
+  statistics.AddGenerated();
+  statistics.UpdateOpenSize(openNodes.Size());
 }
 
-template<typename CellType>
-void Pathfinder<CellType>::ExpandNode(NodeType& node)
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::Reset(CellType origin)
 {
-  for (auto& validMove : moves->FindValidMoves(node))
+  statistics = StatType();
+  pruningCost = std::numeric_limits<Time>::max();
+
+  nodes.Clear();
+  nodeIds.Clear();
+  openNodes.Reset();
+
+  AddOrigin(origin);
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::Reset(CellType origin, std::shared_ptr<Heuristic<CellType>> inHeuristic)
+{
+  heuristic = inHeuristic;
+  Reset(origin);
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::SetGridBounds(uint32_t width, uint32_t height)
+{
+  nodeIds.SetBounds(width, height);
+  targetIds.SetBounds(width, height);
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::SetHeuristicWeight(Time weight)
+{
+  assert(weight >= 1);
+  heuristicWeight = weight;
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::ExpandNode(NodeID node)
+{
+  // The arena may grow while new nodes are added, so the expanded node is accessed by ID
+  const Time nodeTime = nodes[node].minTime;
+
+  PhaseTimer movesTimer;
+  NodeID parent = nodes[node].parent;
+  validMoves.clear();
+  moves->AppendSuccessors(nodes[node], parent == INVALID_NODE_ID ? nullptr : &nodes[parent], validMoves);
+  statistics.AddMovesTime(movesTimer.Elapsed());
+
+  for (auto& validMove : validMoves)
   {
     const CellType& destination = validMove.destination;
     const Time& cost = validMove.cost;
 
     // Check if a potential node exists
-    auto potential_node = nodes.find(destination);
-    if (potential_node == nodes.end())
+    NodeID potentialNode = nodeIds.Find(destination);
+    if (potentialNode == INVALID_NODE_ID)
     {
+      PhaseTimer heuristicTimer;
       heuristic->FindCost(destination);
-      if (!heuristic->IsCostFound(destination))
+      bool isHeuristicFound = heuristic->IsCostFound(destination);
+      Time heuristicCost = isHeuristicFound ? heuristicWeight * heuristic->GetCost(destination) : 0;
+      statistics.AddHeuristicTime(heuristicTimer.Elapsed());
+
+      if (!isHeuristicFound || nodeTime + cost + heuristicCost >= pruningCost)
       {
         continue;
       }
 
       // Create a new node.
-      auto insert_result = nodes.insert({ 
-        destination, 
-        NodeType(
-          destination, 
-          node.minTime + cost,
-          heuristic->GetCost(destination)
-        )
-      });
-
-      NodeType& inserted_node = insert_result.first->second;
-      inserted_node.arrivalCost = validMove.arrivalCost;
-      openNodes.Insert(inserted_node);
+      NodeType newNode(destination, nodeTime + cost, heuristicCost);
+      newNode.arrivalCost = validMove.arrivalCost;
 
       // Set the parential node.
-      inserted_node.parent = &node;
+      newNode.parent = node;
+
+      NodeID insertedNode = nodes.Add(newNode);
+      nodeIds.Set(destination, insertedNode);
+      openNodes.Insert(insertedNode);
+      statistics.AddGenerated();
     }
     else
     {
-      if (potential_node->second.heursticToGoal >= 0 && potential_node->second.minTime > node.minTime + cost)
+      statistics.AddDuplicate();
+
+      NodeType& existingNode = nodes[potentialNode];
+      if (existingNode.heursticToGoal >= 0 && existingNode.minTime > nodeTime + cost)
       {
-        openNodes.ImproveTime(potential_node->second, node.minTime + cost);
+        openNodes.ImproveTime(potentialNode, nodeTime + cost);
+        statistics.AddImproved();
 
-        // Change the parential node to the one which is expanded.
-        potential_node->second.parent = &node;
+        // Change the parential node to the one which is expanded, the arrival cost belongs to its move.
+        existingNode.parent = node;
+        existingNode.arrivalCost = validMove.arrivalCost;
       }
       // If the potential node is in the close list, we never reopen/reexpand it.
     }
   }
 }
 
-template<typename CellType>
-Time Pathfinder<CellType>::GetCost(CellType to) const
+template<typename CellType, typename OpenListType>
+Time Pathfinder<CellType, OpenListType>::GetCost(CellType to) const
 {
   assert(IsCostFound(to));
 
-  return nodes.at(to).minTime;
+  return nodes[nodeIds.Find(to)].minTime;
 }
 
-template<typename CellType>
-bool Pathfinder<CellType>::IsCostFound(CellType to) const
+template<typename CellType, typename OpenListType>
+bool Pathfinder<CellType, OpenListType>::IsCostFound(CellType to) const
 {
-  return nodes.count(to) > 0;
+  return nodeIds.Find(to) != INVALID_NODE_ID;
 }
 
-template<typename CellType>
-void Pathfinder<CellType>::FindCost(CellType to)
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::FindCost(CellType to)
 {
   statistics.StartTimer();
 
   while (!IsCostFound(to) && openNodes.Size())
   {
-    statistics.IncrementSteps();
+    NodeID expandedNode = ExpandMin();
+    TryToStopSearch(expandedNode, to);
+  }
 
-    NodeType& expanded_node = *openNodes.PopMin();
-    expanded_node.MarkClosed();
+  StopTimer();
+}
 
-    ExpandNode(expanded_node);
-    TryToStopSearch(expanded_node, to);
-  }
+template<typename CellType, typename OpenListType>
+NodeID Pathfinder<CellType, OpenListType>::ExpandMin()
+{
+  statistics.IncrementSteps();
 
-  statistics.SetNodesCount(nodes.size());
+  NodeID expandedNode = openNodes.PopMin();
+  nodes[expandedNode].MarkClosed();
+
+  ExpandNode(expandedNode);
+  statistics.UpdateOpenSize(openNodes.Size());
+  return expandedNode;
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::StopTimer()
+{
+  statistics.SetNodesCount(nodes.Size());
+  statistics.SetHeapCounts(openNodes.GetPushesCount(), openNodes.GetPopsCount());
   statistics.StopTimer();
 }
 
-template<typename CellType>
-void Pathfinder<CellType>::CollectPath(CellType to, ArrayType<NodeType>& path) const
+template<typename CellType, typename OpenListType>
+bool Pathfinder<CellType, OpenListType>::IsCostSettled(CellType to) const
+{
+  NodeID node = nodeIds.Find(to);
+  return node != INVALID_NODE_ID && nodes[node].heursticToGoal < 0;
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::SettleCost(CellType to)
+{
+  statistics.StartTimer();
+
+  while (!IsCostSettled(to) && openNodes.Size())
+  {
+    ExpandMin();
+  }
+
+  StopTimer();
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::SettleAll()
+{
+  statistics.StartTimer();
+
+  while (openNodes.Size())
+  {
+    ExpandMin();
+  }
+
+  StopTimer();
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::FindCosts(const ArrayType<CellType>& targets, ArrayType<Time>& costs,
+  Time bound, ArrayType<ArrayType<NodeType>>* paths)
+{
+  statistics.StartTimer();
+
+  // Repeated targets are counted once
+  size_t remainingTargets = 0;
+  targetIds.Clear();
+  for (size_t i = 0; i < targets.size(); ++i)
+  {
+    if (targetIds.Find(targets[i]) != INVALID_NODE_ID) continue;
+
+    targetIds.Set(targets[i], (NodeID) i);
+    if (!IsCostSettled(targets[i])) remainingTargets++;
+  }
+
+  while (remainingTargets > 0 && openNodes.Size())
+  {
+    NodeID expandedNode = ExpandMin();
+    if (targetIds.Find(nodes[expandedNode].cell) != INVALID_NODE_ID) remainingTargets--;
+    if (nodes[expandedNode].minTime > bound) break;
+  }
+
+  StopTimer();
+
+  costs.resize(targets.size());
+  if (paths) paths->resize(targets.size());
+  for (size_t i = 0; i < targets.size(); ++i)
+  {
+    bool isSettled = IsCostSettled(targets[i]) && GetCost(targets[i]) <= bound;
+    costs[i] = isSettled ? GetCost(targets[i]) : UNREACHED_COST;
+
+    if (!paths) continue;
+    if (isSettled)
+    {
+      CollectPath(targets[i], (*paths)[i]);
+    }
+    else
+    {
+      (*paths)[i].clear();
+    }
+  }
+}
+
+template<typename CellType, typename OpenListType>
+void Pathfinder<CellType, OpenListType>::CollectPath(CellType to, ArrayType<NodeType>& path) const
 {
   path.clear();
 
@@ -221,17 +410,16 @@ void Pathfinder<CellType>::CollectPath(CellType to, ArrayType<NodeType>& path) c
     return;
   }
 
-  statistics.StartTimer();
+  PhaseTimer pathTimer;
 
-  const NodeType* currentNode = &nodes.at(to);
-  while (currentNode)
+  for (NodeID currentNode = nodeIds.Find(to); currentNode != INVALID_NODE_ID; currentNode = nodes[currentNode].parent)
   {
-    path.push_back(NodeType(currentNode->cell, currentNode->minTime, currentNode->heursticToGoal));
-    path.back().arrivalCost = currentNode->arrivalCost;
-    currentNode = currentNode->parent;
+    const NodeType& pathNode = nodes[currentNode];
+    path.push_back(NodeType(pathNode.cell, pathNode.minTime, pathNode.heursticToGoal));
+    path.back().arrivalCost = pathNode.arrivalCost;
   }
 
   std::reverse(path.begin(), path.end());
 
-  statistics.StopTimer();
+  statistics.AddPathTime(pathTimer.Elapsed());
 }
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "pathfinder.h"
+#include "heuristic_cache.h"
+#include "segment_moves.h"
+#include "search_result.h"
+#include "shapes.h"
+#include "space.h"
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+#define ROLLING_HORIZON_HEURISTIC_CAPACITY 256
+
+/**
+ * Stream of goals for lifelong planning. It is asked for a new goal
+ * every time an agent reaches its goal, and once for every agent at the start.
+ */
+class TaskSource
+{
+public:
+  // Returns false if there are no tasks for the agent now
+  virtual bool NextGoal(uint32_t agent, Point position, Point& goal) = 0;
+
+  virtual ~TaskSource() {};
+};
+
+/**
+ * Hands out goals in order to whoever asks first.
+ */
+class GoalQueue : public TaskSource
+{
+protected:
+  ArrayType<Point> goals;
+  size_t nextGoal = 0;
+
+public:
+  GoalQueue(const ArrayType<Point>& inGoals)
+    : goals(inGoals)
+  { }
+
+  virtual bool NextGoal(uint32_t, Point, Point& goal) override
+  {
+    if (nextGoal >= goals.size()) return false;
+
+    goal = goals[nextGoal++];
+    return true;
+  }
+};
+
+struct TickResult
+{
+  // Time after the tick
+  Time time = 0;
+  // Wall time of replanning in seconds
+  double planningTime = 0;
+  size_t replannedAgents = 0;
+  size_t failedAgents = 0;
+  size_t reachedGoals = 0;
+};
+
+/**
+ * Lifelong planning with a rolling horizon. Every agent holds a windowed plan of depth
+ * which is reserved in the shared space, agents are planned one after another (prioritized planning).
+ * Each tick moves time forward, commits the executed prefixes of the plans, assigns new goals
+ * from the task source and replans only agents which got a new goal, executed replanPeriod of their plan
+ * or have no plan left. Agents in the middle of a move finish it and are replanned on later ticks.
+ * An agent which can't be replanned keeps its old plan and then waits at its end,
+ * if it got a new goal it's replanned again on every tick until it succeeds.
+ */
+template<typename MoveSet = EightConnectedMoves>
+class RollingHorizonEngine
+{
+protected:
+  struct AgentState
+  {
+    Point position;
+    Point goal;
+    bool hasGoal = false;
+    // Set by a new goal and kept until the agent is replanned, agents in the middle of a move wait for it
+    bool needsReplan = false;
+
+    // Plan starts at the current node, times are counted from the moment the plan was made
+    ArrayType<Node<Area>> plan;
+    Time planAge = 0;
+
+    // Reserved areas in the current window, the last shape.size() of them are the footprint at the end of the plan
+    ArrayType<Area> reservation;
+    size_t goalsReached = 0;
+  };
+
+  std::shared_ptr<const RawSpace> baseSpace;
+  Shape shape;
+  Time depth;
+  Time replanPeriod;
+  std::shared_ptr<TaskSource> tasks;
+
+  std::shared_ptr<SpaceTime> space;
+  std::shared_ptr<ShapeSpace> agentSpace;
+  HeuristicCache heuristicCache;
+  WindowedPathfinder<Area> pathfinder;
+
+  ArrayType<AgentState> agents;
+  ArrayType<Area> extendedAreas;
+
+  Time time = 0;
+  size_t reachedGoals = 0;
+  double planningTime = 0;
+  TickResult lastTick;
+
+protected:
+  void ReserveFootprint(AgentState& agent, Segment interval)
+  {
+    agent.reservation.clear();
+    for (const Point& deltaPoint : shape.shape)
+    {
+      agent.reservation.push_back(Area(agent.position + deltaPoint, interval));
+    }
+
+    space->MakeAreasInaccessable(agent.reservation);
+  }
+
+  // Shifts the reservation with the window and keeps the footprint at the end of the plan until the new depth
+  void MoveReservation(AgentState& agent, Time deltaTime)
+  {
+    size_t tailStart = agent.reservation.size() - shape.shape.size();
+    size_t kept = 0;
+    for (size_t i = 0; i < agent.reservation.size(); ++i)
+    {
+      Area area = agent.reservation[i];
+      area.interval.start = std::max(Time(0), area.interval.start - deltaTime);
+      area.interval.end -= deltaTime;
+
+      if (i >= tailStart)
+      {
+        Segment extension{ std::max(Time(0), depth - deltaTime), depth };
+        extendedAreas.push_back(Area(area.point, extension));
+        area.interval.end = depth;
+      }
+      else if (area.interval.end < 0)
+      {
+        continue;
+      }
+
+      agent.reservation[kept++] = area;
+    }
+
+    agent.reservation.resize(kept);
+  }
+
+  // Index of the last node of the plan which is reached by now
+  size_t FindCurrentNode(const AgentState& agent) const
+  {
+    size_t current = 0;
+    while (current + 1 < agent.plan.size() && agent.plan[current + 1].minTime <= agent.planAge)
+    {
+      ++current;
+    }
+
+    return current;
+  }
+
+  bool IsMoving(const AgentState& agent) const
+  {
+    if (agent.plan.size() < 2) return false;
+
+    const Node<Area>& next = agent.plan[1];
+    return agent.planAge > next.minTime - next.arrivalCost;
+  }
+
+  bool IsPlanExecuted(const AgentState& agent) const
+  {
+    return agent.plan.empty() || agent.planAge >= agent.plan.back().minTime;
+  }
+
+  bool Replan(AgentState& agent)
+  {
+    // The agent doesn't collide with itself
+    for (const Area& area : agent.reservation)
+    {
+      if (space->ContainsSegmentsIn(area.point)) space->SetAccess(area, Access::Accessable);
+    }
+
+    agentSpace->UpdateShape(agent.position);
+    if (agentSpace->ContainsSegmentsIn(agent.position))
+    {
+      for (Segment segment : agentSpace->GetSegments(agent.position))
+      {
+        if (segment.start > 0 || segment.end < 0) continue;
+
+        std::shared_ptr<Heuristic<Area>> heuristic(new SpaceAdapter<Point, Area>(heuristicCache.Get(agent.goal, shape)));
+        pathfinder.Reset(Area{ agent.position, segment }, heuristic);
+
+        Area destination = Area::FromDepth(agent.goal, depth);
+        pathfinder.FindCost(destination);
+        if (!pathfinder.IsCostFound(destination)) break;
+
+        pathfinder.CollectPath(destination, agent.plan);
+        agent.planAge = 0;
+        FromPathToFilledAreas(agent.plan, shape, agent.reservation);
+        space->MakeAreasInaccessable(agent.reservation);
+        return true;
+      }
+    }
+
+    space->MakeAreasInaccessable(agent.reservation);
+    return false;
+  }
+
+public:
+  RollingHorizonEngine(std::shared_ptr<const RawSpace> inSpace, const Shape& inShape, Time inDepth, Time inReplanPeriod,
+    std::shared_ptr<TaskSource> inTasks)
+    : baseSpace(inSpace)
+    , shape(inShape)
+    , depth(inDepth)
+    , replanPeriod(inReplanPeriod)
+    , tasks(inTasks)
+    , space(std::make_shared<SpaceTime>(inDepth, *inSpace))
+    , agentSpace(std::make_shared<ShapeSpace>(inDepth, space, inShape, std::make_shared<RawSpace>(ErodeByShape(*inSpace, inShape))))
+    , heuristicCache(inSpace, MakeMoves<MoveSet>(), ROLLING_HORIZON_HEURISTIC_CAPACITY)
+    , pathfinder(std::make_shared<SegmentMoves<MoveSet>>(agentSpace, inDepth), Area{ Point{ 0, 0 }, { 0, inDepth } }, nullptr, inDepth)
+  {
+    assert(replanPeriod > 0 && replanPeriod <= depth);
+  }
+
+  RollingHorizonEngine(const RollingHorizonEngine& other) = delete;
+  RollingHorizonEngine& operator=(const RollingHorizonEngine& other) = delete;
+
+  /**
+   * Places an agent which waits at the position until it gets a goal on the next tick.
+   * Returns false if the footprint of the agent isn't free for the whole window.
+   */
+  bool AddAgent(Point position)
+  {
+    agentSpace->UpdateShape(position);
+    if (!agentSpace->ContainsSegmentsIn(position) || !agentSpace->GetSegments(position).Contains({ 0, depth }))
+    {
+      return false;
+    }
+
+    AgentState agent;
+    agent.position = position;
+    ReserveFootprint(agent, { 0, depth });
+    agents.push_back(std::move(agent));
+    return true;
+  }
+
+  const TickResult& Tick(Time deltaTime)
+  {
+    assert(deltaTime > 0);
+
+    time += deltaTime;
+    space->MoveTime(deltaTime);
+
+    TickResult result;
+    result.time = time;
+
+    // Execute plans
+    extendedAreas.clear();
+    for (AgentState& agent : agents)
+    {
+      agent.planAge += deltaTime;
+      MoveReservation(agent, deltaTime);
+
+      size_t current = FindCurrentNode(agent);
+      agent.plan.erase(agent.plan.begin(), agent.plan.begin() + current);
+      if (!agent.plan.empty()) agent.position = agent.plan.front().cell.point;
+    }
+    space->MakeAreasInaccessable(extendedAreas);
+
+    // Replan agents with new goals and expired windows
+    StatTimer planningTimer;
+    for (uint32_t agentId = 0; agentId < agents.size(); ++agentId)
+    {
+      AgentState& agent = agents[agentId];
+
+      if (agent.hasGoal && agent.position == agent.goal)
+      {
+        agent.hasGoal = false;
+        agent.goalsReached++;
+        result.reachedGoals++;
+      }
+      if (!agent.hasGoal && tasks->NextGoal(agentId, agent.position, agent.goal))
+      {
+        agent.hasGoal = true;
+        agent.needsReplan = true;
+      }
+
+      if (!agent.hasGoal || IsMoving(agent)) continue;
+      if (!agent.needsReplan && agent.planAge < replanPeriod && !IsPlanExecuted(agent)) continue;
+
+      if (Replan(agent))
+      {
+        agent.needsReplan = false;
+        result.replannedAgents++;
+      }
+      else
+      {
+        result.failedAgents++;
+      }
+    }
+    result.planningTime = planningTimer.Elapsed();
+
+    reachedGoals += result.reachedGoals;
+    planningTime += result.planningTime;
+    lastTick = result;
+    return lastTick;
+  }
+
+  Time GetTime() const { return time; }
+
+  size_t GetAgentsCount() const { return agents.size(); }
+  Point GetAgentPosition(uint32_t agentId) const { return agents[agentId].position; }
+  size_t GetAgentGoalsReached(uint32_t agentId) const { return agents[agentId].goalsReached; }
+
+  size_t GetReachedGoals() const { return reachedGoals; }
+
+  // Goals reached per unit of simulated time
+  double GetThroughput() const { return time > 0 ? reachedGoals / time : 0; }
+
+  double GetPlanningTime() const { return planningTime; }
+  const TickResult& GetLastTick() const { return lastTick; }
+};
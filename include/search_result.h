@@ -0,0 +1,148 @@
+#pragma once
+
+#include "search_types.h"
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+
+/**
+ * Measures time from its creation, in seconds.
+ */
+class StatTimer
+{
+private:
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+public:
+  inline double Elapsed() const
+  {
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    return duration.count();
+  }
+};
+
+#ifdef SEARCH_PHASE_TIMINGS
+using PhaseTimer = StatTimer;
+#else
+// Doesn't read the clock, phase times are off
+struct PhaseTimer
+{
+  inline double Elapsed() const { return 0; }
+};
+#endif
+
+/**
+ * Telemetry of a search. Times are in seconds and are accumulated over all calls
+ * that continue the search (FindCost, SettleCost, ...) until the pathfinder is reset.
+ * Times of moves, heuristic and path collection read the clock for every node, so they stay zero
+ * unless SEARCH_PHASE_TIMINGS is defined. Heap pushes and pops are entries of the open list,
+ * so with lazy open lists they include outdated entries.
+ */
+template<typename CellType>
+class SearchResult
+{
+private:
+  StatTimer timer;
+
+  // Time of the search itself, path collection is measured separately
+  double time = 0;
+  double movesTime = 0;
+  double heuristicTime = 0;
+  double pathTime = 0;
+
+  size_t nodescreated = 0;
+  size_t numberofsteps = 0;
+  size_t generatedNodes = 0;
+  size_t duplicateNodes = 0;
+  size_t improvedNodes = 0;
+  size_t heapPushes = 0;
+  size_t heapPops = 0;
+  size_t peakOpenSize = 0;
+
+public:
+  inline void IncrementSteps()
+  {
+    numberofsteps++;
+  }
+
+  inline void SetNodesCount(size_t inNodesCount)
+  {
+    nodescreated = inNodesCount;
+  }
+
+  inline void SetHeapCounts(size_t inHeapPushes, size_t inHeapPops)
+  {
+    heapPushes = inHeapPushes;
+    heapPops = inHeapPops;
+  }
+
+  inline void StartTimer()
+  {
+    timer = StatTimer();
+  }
+
+  inline void StopTimer()
+  {
+    time += timer.Elapsed();
+  }
+
+  inline void AddGenerated() { generatedNodes++; }
+  inline void AddDuplicate() { duplicateNodes++; }
+  inline void AddImproved() { improvedNodes++; }
+  inline void UpdateOpenSize(size_t openSize) { peakOpenSize = std::max(peakOpenSize, openSize); }
+
+  inline void AddMovesTime(double seconds) { movesTime += seconds; }
+  inline void AddHeuristicTime(double seconds) { heuristicTime += seconds; }
+  inline void AddPathTime(double seconds) { pathTime += seconds; }
+
+  double GetTime() const { return time; }
+  double GetMovesTime() const { return movesTime; }
+  double GetHeuristicTime() const { return heuristicTime; }
+  double GetPathTime() const { return pathTime; }
+
+  // Number of expanded nodes, each of them is closed
+  size_t GetStepsCount() const { return numberofsteps; }
+  size_t GetNodesCount() const { return nodescreated; }
+  size_t GetGeneratedCount() const { return generatedNodes; }
+  size_t GetDuplicatesCount() const { return duplicateNodes; }
+  size_t GetImprovedCount() const { return improvedNodes; }
+  size_t GetHeapPushesCount() const { return heapPushes; }
+  size_t GetHeapPopsCount() const { return heapPops; }
+  size_t GetPeakOpenSize() const { return peakOpenSize; }
+
+  static void WriteCsvHeader(std::ostream& output);
+  void WriteCsvRow(std::ostream& output) const;
+  void WriteJson(std::ostream& output) const;
+};
+
+template<typename CellType>
+void SearchResult<CellType>::WriteCsvHeader(std::ostream& output)
+{
+  output << "time,moves_time,heuristic_time,path_time,expansions,nodes,generated,duplicates,improved,"
+    "heap_pushes,heap_pops,peak_open\n";
+}
+
+template<typename CellType>
+void SearchResult<CellType>::WriteCsvRow(std::ostream& output) const
+{
+  output << time << "," << movesTime << "," << heuristicTime << "," << pathTime << ","
+    << numberofsteps << "," << nodescreated << "," << generatedNodes << "," << duplicateNodes << ","
+    << improvedNodes << "," << heapPushes << "," << heapPops << "," << peakOpenSize << "\n";
+}
+
+template<typename CellType>
+void SearchResult<CellType>::WriteJson(std::ostream& output) const
+{
+  output << "{\"time\": " << time
+    << ", \"moves_time\": " << movesTime
+    << ", \"heuristic_time\": " << heuristicTime
+    << ", \"path_time\": " << pathTime
+    << ", \"expansions\": " << numberofsteps
+    << ", \"nodes\": " << nodescreated
+    << ", \"generated\": " << generatedNodes
+    << ", \"duplicates\": " << duplicateNodes
+    << ", \"improved\": " << improvedNodes
+    << ", \"heap_pushes\": " << heapPushes
+    << ", \"heap_pops\": " << heapPops
+    << ", \"peak_open\": " << peakOpenSize << "}";
+}
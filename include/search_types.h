@@ -72,6 +72,11 @@ struct Point
 
 MAKE_HASHABLE(Point, type.x, type.y);
 
+// Nodes are stored in a contiguous arena and are referenced by 32-bit IDs
+using NodeID = uint32_t;
+
+#define INVALID_NODE_ID UINT32_MAX
+
 template<typename CellType>
 struct Node
 {
@@ -80,8 +85,8 @@ struct Node
   // If minTime < 0 the node is currently inaccessable, 
   // else minTime = current min time to reach the node
   Time  minTime, heursticToGoal;
-  size_t heapIndex;
-  Node<CellType>* parent;
+  uint32_t heapIndex;
+  NodeID parent;
   Time arrivalCost = 0;
 
   Node();
@@ -96,7 +101,7 @@ Node<CellType>::Node(CellType inCell)
   : cell(inCell)
   , minTime(0)
   , heursticToGoal(-1)
-  , parent(nullptr)
+  , parent(INVALID_NODE_ID)
   , heapIndex(0)
 { }
 
@@ -105,7 +110,7 @@ Node<CellType>::Node(CellType inCell, Time inMinTime, Time inHeuristic)
   : cell(inCell)
   , minTime(inMinTime)
   , heursticToGoal(inHeuristic)
-  , parent(nullptr)
+  , parent(INVALID_NODE_ID)
   , heapIndex(0)
 { }
 
@@ -114,6 +119,6 @@ Node<CellType>::Node()
   : cell()
   , minTime(-1)
   , heursticToGoal(-1)
-  , parent(nullptr)
+  , parent(INVALID_NODE_ID)
   , heapIndex(0)
 { }
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "search_types.h"
+#include "segments.h"
+#include "shapes.h"
+#include "moves.h"
+#include "move_sets.h"
+#include <memory>
+
+/**
+ * Moves of a shaped agent over the footprints of a ShapeSpace with a compile-time move set.
+ * Area moves go to every safe interval of a neighbor which can be entered in time,
+ * a node which interval lasts until the depth can also wait until the end of the window.
+ * Point moves ignore time and only check that a footprint exists.
+ * Other required neighbors of a move (see GridMoveOffset) are passed by the agent, their footprints
+ * must be free while it moves.
+ */
+template<typename MoveSet>
+class SegmentMoves : public MoveComponent<Area>, public MoveComponent<Point>
+{
+protected:
+  Time depth;
+  std::shared_ptr<ShapeSpace> space;
+
+  struct NoReadRecorder
+  {
+    inline void OnFootprintRead(Point) { }
+    inline void OnSegmentUsed(Point, Segment) { }
+  };
+
+  // Required neighbors of the move besides its destination
+  static inline uint8_t GetPassedNeighbors(const GridMoveOffset& move)
+  {
+    return move.requiredNeighbors & ~NeighborMask(move.x, move.y);
+  }
+
+  static inline Point GetNeighbor(Point origin, int index)
+  {
+    return { origin.x + RawSpace::NeighborOffsets[index].x, origin.y + RawSpace::NeighborOffsets[index].y };
+  }
+
+  // The footprint of the point is free at some time
+  inline bool HasFootprint(Point point)
+  {
+    space->UpdateShape(point);
+    if (!space->ContainsSegmentsIn(point)) return false;
+
+    const SegmentHolder& segHolder = space->GetSegments(point);
+    return segHolder.begin() != segHolder.end();
+  }
+
+  // Times when footprints of all passed neighbors are free, false if there are none
+  template<typename Recorder>
+  bool FindPassableTimes(Point origin, uint8_t passedNeighbors, SegmentHolder& passable, Recorder& recorder)
+  {
+    bool isFirst = true;
+    for (int i = 0; i < 8; ++i)
+    {
+      if (!(passedNeighbors & (uint8_t(1) << i))) continue;
+
+      Point neighbor = GetNeighbor(origin, i);
+      recorder.OnFootprintRead(neighbor);
+      space->UpdateShape(neighbor);
+      if (!space->ContainsSegmentsIn(neighbor)) return false;
+
+      const SegmentHolder& segHolder = space->GetSegments(neighbor);
+      passable = isFirst ? segHolder : passable & segHolder;
+      isFirst = false;
+      if (passable.begin() == passable.end()) return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Recorder gets every footprint the moves depend on and every segment of it
+   * which overlaps the time when the agent can leave the node.
+   */
+  template<typename Recorder>
+  void AppendAreaMoves(const Node<Area>& node, ArrayType<Move<Area>>& result, Recorder& recorder)
+  {
+    Area origin = node.cell;
+
+    Segment moveAvailable{ node.minTime, node.cell.interval.end };
+    if (node.cell.interval.end >= depth)
+    {
+      result.push_back({ moveAvailable.GetLength(), Area{origin, {depth, depth}}, 0 });
+    }
+
+    for (const GridMoveOffset& move : MoveSet::Moves)
+    {
+      Point destinationPoint = { origin.point.x + move.x, origin.point.y + move.y };
+
+      uint8_t passedNeighbors = GetPassedNeighbors(move);
+      SegmentHolder passable;
+      if (passedNeighbors && !FindPassableTimes(origin.point, passedNeighbors, passable, recorder)) continue;
+
+      recorder.OnFootprintRead(destinationPoint);
+      space->UpdateShape(destinationPoint);
+      if (!space->ContainsSegmentsIn(destinationPoint)) continue;
+      const SegmentHolder& segHolder = space->GetSegments(destinationPoint);
+
+      for (Segment segment : segHolder)
+      {
+        // TODO mechanism to check collision with other cells (example: move from (0, 0) to (5, 5)
+        Segment both = moveAvailable & segment;
+        if (!both.IsValid()) continue;
+
+        recorder.OnSegmentUsed(destinationPoint, segment);
+        if (passedNeighbors)
+        {
+          // The earliest time when the passed neighbors stay free during the whole move
+          Segment window = Segment::Invalid();
+          for (Segment free : passable)
+          {
+            window = both & free;
+            if (window.IsValid() && window.GetLength() >= move.cost) break;
+            window = Segment::Invalid();
+          }
+
+          for (int i = 0; i < 8; ++i)
+          {
+            if (passedNeighbors & (uint8_t(1) << i)) recorder.OnSegmentUsed(GetNeighbor(origin.point, i), both);
+          }
+
+          if (!window.IsValid()) continue;
+          both = window;
+        }
+
+        if (both.GetLength() >= move.cost)
+        {
+          Time overallCost = both.start + move.cost - node.minTime;
+          result.push_back({ overallCost, Area{destinationPoint, segment}, move.cost });
+        }
+      }
+    }
+  }
+
+public:
+  SegmentMoves(std::shared_ptr<ShapeSpace> inSpace, Time inDepth)
+    : depth(inDepth)
+    , space(inSpace)
+  { }
+
+  virtual ArrayType<Move<Area>> FindValidMoves(const Node<Area>& node) override
+  {
+    ArrayType<Move<Area>> result;
+    AppendValidMoves(node, result);
+    return result;
+  }
+
+  virtual void AppendValidMoves(const Node<Area>& node, ArrayType<Move<Area>>& result) override
+  {
+    NoReadRecorder recorder;
+    AppendAreaMoves(node, result, recorder);
+  }
+
+  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override
+  {
+    ArrayType<Move<Point>> result;
+    AppendValidMoves(node, result);
+    return result;
+  }
+
+  virtual void AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& result) override
+  {
+    Point origin = node.cell;
+
+    for (const GridMoveOffset& move : MoveSet::Moves)
+    {
+      Point destinationPoint = { origin.x + move.x, origin.y + move.y };
+
+      if (!HasFootprint(destinationPoint)) continue;
+
+      uint8_t passedNeighbors = GetPassedNeighbors(move);
+      bool isPassable = true;
+      for (int i = 0; i < 8 && isPassable; ++i)
+      {
+        if (passedNeighbors & (uint8_t(1) << i)) isPassable = HasFootprint(GetNeighbor(origin, i));
+      }
+      if (!isPassable) continue;
+
+      // TODO mechanism to check collision with other cells (example: move from (0, 0) to (5, 5)
+      result.push_back({ move.cost, destinationPoint, move.cost });
+    }
+  }
+};
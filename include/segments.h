@@ -1,6 +1,7 @@
 #pragma once
 
 #include "search_types.h"
+#include "small_array.h"
 
 /**
  * Segment desribes time from the start to the end including both points.
@@ -40,11 +41,22 @@ struct Segment
 
 MAKE_HASHABLE(Segment, type.start, type.end);
 
+// Most cells hold a few safe intervals, so they are stored without dynamic memory
+#define SEGMENT_HOLDER_INLINE_CAPACITY 3
+
+/**
+ * Disjoint segments sorted by time.
+ */
 class SegmentHolder
 {
 private:
-  SetType<Segment> segments;
-  using const_iterator = SetType<Segment>::const_iterator;
+  SmallArray<Segment, SEGMENT_HOLDER_INLINE_CAPACITY> segments;
+  using const_iterator = const Segment*;
+
+  // Index of the first segment which isn't less than the given one
+  size_t LowerBound(Segment segment) const;
+  // Index of the first segment which is greater than the given one
+  size_t UpperBound(Segment segment) const;
 
 public:
   SegmentHolder();
@@ -66,6 +78,12 @@ public:
   bool operator==(const SegmentHolder& other) const;
   void operator-=(Time deltaTime);
 
+  /**
+   * Moves the window [0, depth] forward by deltaTime: segments are shifted back,
+   * the parts before zero are removed and [depth - deltaTime, depth] becomes free.
+   */
+  void MoveWindow(Time deltaTime, Time depth);
+
   bool Contains(Segment segment) const;
 };
 
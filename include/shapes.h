@@ -10,22 +10,77 @@ struct Shape
   ArrayType<Point> shape;
 
   ArrayType<Point> ApplyShapeTo(Point point) const;
+
+  bool operator==(const Shape& other) const { return shape == other.shape; }
 };
 
-class ShapeSpace : public SpaceTime
+namespace std {
+  template<> struct hash<Shape> {
+    size_t operator()(const Shape& type) const {
+      size_t ret = 0;
+      for (const Point& point : type.shape) hash_combine(ret, point);
+      return ret;
+    }
+  };
+}
+
+/**
+ * Space of footprints: segments of a point are the intersection of segments
+ * of the original space under the shape applied to the point.
+ * Footprints are computed by UpdateShape and are recomputed after the original space
+ * changes under them, so one ShapeSpace can be used while reservations are added
+ * and while time moves.
+ * The original space can also be a snapshot, then footprints follow SetSnapshot.
+ */
+class ShapeSpace : public SpaceTime, public SegmentSpaceListener
 {
 private:
   std::shared_ptr<SegmentSpace> originalSpace;
+  std::shared_ptr<const SegmentSnapshot> snapshot;
   Shape shape;
 
-  std::unordered_set<Area> pointCache;
+  // Optional static footprints of the shape, see ErodeByShape
+  std::shared_ptr<const RawSpace> footprintMap;
+
+  // Points which footprints are already computed, points outside of the grid are kept in the set
+  ArrayType<bool> isUpdated;
+  std::unordered_set<Point> pointCache;
+
+  inline const SegmentHolder* FindOriginalSegments(Point point) const
+  {
+    if (snapshot) return snapshot->Find(point);
+    return originalSpace->ContainsSegmentsIn(point) ? &originalSpace->GetSegments(point) : nullptr;
+  }
 
 public:
   ShapeSpace() = delete;
   ShapeSpace(Time depth, const RawSpace& base) = delete;
-  ShapeSpace(Time depth, std::shared_ptr<SegmentSpace> inSpace, const Shape& inShape);
+  ShapeSpace(Time depth, std::shared_ptr<SegmentSpace> inSpace, const Shape& inShape,
+    std::shared_ptr<const RawSpace> inFootprintMap = nullptr);
+  ShapeSpace(Time depth, std::shared_ptr<const SegmentSnapshot> inSnapshot, const Shape& inShape,
+    std::shared_ptr<const RawSpace> inFootprintMap = nullptr);
+  ShapeSpace(const ShapeSpace& other) = delete;
+  ShapeSpace& operator=(const ShapeSpace& other) = delete;
+  ~ShapeSpace();
 
   void UpdateShape(Point point);
+
+  // Marks footprints which cover the point as outdated
+  virtual void OnSegmentsChanged(Point point) override;
+
+  // Moves the window of the footprints with the original space
+  virtual void OnTimeMoved(Time deltaTime) override;
+
+  // Switches to another version of the snapshot, only footprints over changed tiles become outdated
+  void SetSnapshot(std::shared_ptr<const SegmentSnapshot> inSnapshot);
 };
 
+/**
+ * Erodes the space by the shape: a point stays accessable only if every point
+ * of the shape applied to it is accessable. The whole map is processed with
+ * word-level row operations, one pass per point of the shape.
+ * The result can be shared by all agents with the same shape.
+ */
+RawSpace ErodeByShape(const RawSpace& space, const Shape& shape);
+
 void FromPathToFilledAreas(const ArrayType<Node<Area>>& path, const Shape& shape, ArrayType<Area>& areas);
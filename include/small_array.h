@@ -0,0 +1,217 @@
+#pragma once
+
+#include <inttypes.h>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Array which keeps up to InlineCapacity elements inside of the object
+ * and moves them to dynamic memory only when it grows beyond that.
+ * Only trivially copyable elements are supported.
+ */
+template<typename T, uint32_t InlineCapacity>
+class SmallArray
+{
+  static_assert(std::is_trivially_copyable_v<T>, "SmallArray: elements must be trivially copyable");
+  static_assert(InlineCapacity > 0, "SmallArray: inline capacity must be positive");
+
+private:
+  uint32_t size;
+  uint32_t capacity;
+
+  union
+  {
+    T inlineElements[InlineCapacity];
+    T* heapElements;
+  };
+
+  inline bool IsInline() const { return capacity == InlineCapacity; }
+
+  void Grow(uint32_t minCapacity);
+  void Release();
+
+public:
+  SmallArray();
+  SmallArray(const SmallArray& other);
+  SmallArray(SmallArray&& other) noexcept;
+  ~SmallArray();
+
+  SmallArray& operator=(const SmallArray& other);
+  SmallArray& operator=(SmallArray&& other) noexcept;
+
+  inline T* Data() { return IsInline() ? inlineElements : heapElements; }
+  inline const T* Data() const { return IsInline() ? inlineElements : heapElements; }
+
+  inline T* begin() { return Data(); }
+  inline T* end() { return Data() + size; }
+  inline const T* begin() const { return Data(); }
+  inline const T* end() const { return Data() + size; }
+
+  inline T& operator[](size_t index) { assert(index < size); return Data()[index]; }
+  inline const T& operator[](size_t index) const { assert(index < size); return Data()[index]; }
+
+  inline size_t Size() const { return size; }
+  inline bool Empty() const { return size == 0; }
+
+  void PushBack(const T& element);
+
+  // Inserts the element before the given index
+  void Insert(size_t index, const T& element);
+
+  // Erases elements in [first, last)
+  void Erase(size_t first, size_t last);
+
+  void Clear() { size = 0; }
+
+  bool operator==(const SmallArray& other) const;
+};
+
+template<typename T, uint32_t InlineCapacity>
+SmallArray<T, InlineCapacity>::SmallArray()
+  : size(0)
+  , capacity(InlineCapacity)
+{ }
+
+template<typename T, uint32_t InlineCapacity>
+SmallArray<T, InlineCapacity>::SmallArray(const SmallArray& other)
+  : SmallArray()
+{
+  operator=(other);
+}
+
+template<typename T, uint32_t InlineCapacity>
+SmallArray<T, InlineCapacity>::SmallArray(SmallArray&& other) noexcept
+  : SmallArray()
+{
+  operator=(std::move(other));
+}
+
+template<typename T, uint32_t InlineCapacity>
+SmallArray<T, InlineCapacity>::~SmallArray()
+{
+  Release();
+}
+
+template<typename T, uint32_t InlineCapacity>
+void SmallArray<T, InlineCapacity>::Release()
+{
+  if (!IsInline())
+  {
+    delete[] heapElements;
+  }
+
+  capacity = InlineCapacity;
+  size = 0;
+}
+
+template<typename T, uint32_t InlineCapacity>
+SmallArray<T, InlineCapacity>& SmallArray<T, InlineCapacity>::operator=(const SmallArray& other)
+{
+  if (this == &other)
+  {
+    return *this;
+  }
+
+  if (other.size > capacity)
+  {
+    Release();
+    Grow(other.size);
+  }
+
+  std::copy(other.begin(), other.end(), Data());
+  size = other.size;
+
+  return *this;
+}
+
+template<typename T, uint32_t InlineCapacity>
+SmallArray<T, InlineCapacity>& SmallArray<T, InlineCapacity>::operator=(SmallArray&& other) noexcept
+{
+  if (this == &other)
+  {
+    return *this;
+  }
+
+  Release();
+
+  if (other.IsInline())
+  {
+    std::copy(other.begin(), other.end(), inlineElements);
+  }
+  else
+  {
+    heapElements = other.heapElements;
+    capacity = other.capacity;
+    other.capacity = InlineCapacity;
+  }
+
+  size = other.size;
+  other.size = 0;
+
+  return *this;
+}
+
+template<typename T, uint32_t InlineCapacity>
+void SmallArray<T, InlineCapacity>::Grow(uint32_t minCapacity)
+{
+  uint32_t newCapacity = std::max(minCapacity, capacity * 2);
+  T* newElements = new T[newCapacity];
+  std::copy(begin(), end(), newElements);
+
+  uint32_t oldSize = size;
+  Release();
+
+  heapElements = newElements;
+  capacity = newCapacity;
+  size = oldSize;
+}
+
+template<typename T, uint32_t InlineCapacity>
+void SmallArray<T, InlineCapacity>::PushBack(const T& element)
+{
+  if (size == capacity)
+  {
+    // The element may be stored inside of the array
+    T copy = element;
+    Grow(size + 1);
+    Data()[size++] = copy;
+    return;
+  }
+
+  Data()[size++] = element;
+}
+
+template<typename T, uint32_t InlineCapacity>
+void SmallArray<T, InlineCapacity>::Insert(size_t index, const T& element)
+{
+  assert(index <= size);
+
+  T copy = element;
+  if (size == capacity)
+  {
+    Grow(size + 1);
+  }
+
+  T* elements = Data();
+  std::copy_backward(elements + index, elements + size, elements + size + 1);
+  elements[index] = copy;
+  ++size;
+}
+
+template<typename T, uint32_t InlineCapacity>
+void SmallArray<T, InlineCapacity>::Erase(size_t first, size_t last)
+{
+  assert(first <= last && last <= size);
+
+  T* elements = Data();
+  std::copy(elements + last, elements + size, elements + first);
+  size -= (uint32_t) (last - first);
+}
+
+template<typename T, uint32_t InlineCapacity>
+bool SmallArray<T, InlineCapacity>::operator==(const SmallArray& other) const
+{
+  return size == other.size && std::equal(begin(), end(), other.begin());
+}
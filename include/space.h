@@ -2,7 +2,10 @@
 
 #include "search_types.h"
 #include "segments.h"
+#include <array>
+#include <bitset>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 
@@ -35,37 +38,173 @@ public:
   virtual ~Space() {};
 };
 
-class RawSpace : public Space<Point>
+/**
+ * Static grid which keeps one bit per cell, set for accessable cells.
+ * Rows are padded to whole 64-bit words, so a row can be scanned word by word.
+ */
+class RawSpace final : public Space<Point>
 {
 private:
-  ArrayType<Access> grid;
   uint32_t width;
   uint32_t height;
+  uint32_t wordsPerRow;
+  ArrayType<uint64_t> words;
 
 private:
-  inline size_t PointToIndex(Point& point) const;
+  inline size_t PointToWord(const Point& point) const;
 
 public:
+  // Order of neighbors in GetAccessableNeighbors masks
+  static const Point NeighborOffsets[8];
+
   RawSpace() = delete;
   RawSpace(uint32_t inWidth, uint32_t inHeight);
 
   Access GetAccess(Point point) const override;
   void SetAccess(Point point, Access newAccess) override;
 
+  // Copies width accesses into the given row
+  void SetRow(uint32_t row, const Access* accesses);
+
+  void Fill(Access access);
+
+  // Keeps a point accessable only if the point + offset is accessable in the source of the same size
+  void IntersectWithShifted(const RawSpace& source, Point offset);
+
+  // Bit i is set if the cell x + i of the row is accessable, count <= 64. Cells outside of the grid are inaccessable
+  uint64_t GetRowBits(int row, int x, uint32_t count) const;
+
+  // True if every point of origin + offsets is inside of the grid and accessable
+  bool AreAllAccessable(Point origin, const ArrayType<Point>& offsets) const;
+
+  // True if cells [from.x, from.x + length) of the row from.y are inside of the grid and accessable
+  bool IsSpanAccessable(Point from, uint32_t length) const;
+
+  // Bit i is set if the point + NeighborOffsets[i] is accessable
+  uint8_t GetAccessableNeighbors(Point point) const;
+
+  /**
+   * Scans the row from the point (inclusive) in the given direction (+1 or -1).
+   * Returns x of the first inaccessable cell, that is -1 or width if the scan leaves the grid.
+   */
+  int FindInaccessableInRow(Point from, int direction) const;
+
   uint32_t GetWidth() const;
   uint32_t GetHeight() const;
 
   bool Contains(Point point) const override;
 };
 
+/**
+ * Segment holders stored in a dense row-major grid with a presence flag per cell.
+ * Points outside of the grid bounds are stored in a hash map.
+ * 
+ * Moving time only changes a global offset. Each holder remembers the offset
+ * it was last synchronised with and is shifted when it is accessed.
+ */
+class SegmentGrid
+{
+private:
+  struct TimedHolder
+  {
+    SegmentHolder segments;
+    Time timeOffset = 0;
+  };
+
+  // Holders are synchronised with the time offset lazily, including const access
+  mutable ArrayType<TimedHolder> holders;
+  ArrayType<bool> isPresent;
+  mutable MapType<Point, TimedHolder> outerHolders;
+  uint32_t width;
+  uint32_t height;
+
+  Time timeOffset;
+  Time depth;
+
+private:
+  inline bool IsInside(const Point& point) const
+  {
+    return point.x >= 0 && (uint32_t) point.x < width && point.y >= 0 && (uint32_t) point.y < height;
+  }
+
+  inline size_t PointToIndex(const Point& point) const
+  {
+    return point.x + (size_t) point.y * width;
+  }
+
+  inline SegmentHolder& Synchronise(TimedHolder& holder) const
+  {
+    if (holder.timeOffset != timeOffset)
+    {
+      holder.segments.MoveWindow(timeOffset - holder.timeOffset, depth);
+      holder.timeOffset = timeOffset;
+    }
+
+    return holder.segments;
+  }
+
+public:
+  SegmentGrid();
+  SegmentGrid(uint32_t inWidth, uint32_t inHeight);
+
+  // Returns nullptr if the grid doesn't contain segments in the point
+  const SegmentHolder* Find(Point point) const;
+  SegmentHolder* Find(Point point);
+
+  // Creates an empty holder if the grid doesn't contain segments in the point
+  SegmentHolder& operator[](Point point);
+
+  /**
+   * Moves the window [0, inDepth] of every holder forward by deltaTime in O(1),
+   * see SegmentHolder::MoveWindow.
+   */
+  void MoveTime(Time deltaTime, Time inDepth);
+
+  uint32_t GetWidth() const { return width; }
+  uint32_t GetHeight() const { return height; }
+};
+
+/**
+ * Receives points which segments were changed in a SegmentSpace.
+ */
+class SegmentSpaceListener
+{
+public:
+  virtual void OnSegmentsChanged(Point point) = 0;
+
+  // Called after SpaceTime::MoveTime, all segments are shifted
+  virtual void OnTimeMoved(Time) {};
+
+  virtual ~SegmentSpaceListener() {};
+};
+
 class SegmentSpace : public Space<Area>
 {
 protected:
-  MapType<Point, SegmentHolder> segmentGrid;
+  SegmentGrid segmentGrid;
+
+  // Listeners are not copied with the space
+  ArrayType<SegmentSpaceListener*> listeners;
+
+  inline void NotifyChanged(Point point)
+  {
+    for (SegmentSpaceListener* listener : listeners)
+    {
+      listener->OnSegmentsChanged(point);
+    }
+  }
 
 public:
   SegmentSpace();
   SegmentSpace(Time depth, const RawSpace& base);
+  SegmentSpace(const SegmentSpace& other);
+  SegmentSpace& operator=(const SegmentSpace& other);
+
+  void AddListener(SegmentSpaceListener* listener);
+  void RemoveListener(SegmentSpaceListener* listener);
+
+  uint32_t GetWidth() const;
+  uint32_t GetHeight() const;
 
   void SetSegments(Point point, const SegmentHolder& newAccess);
   const SegmentHolder& GetSegments(Point point) const;
@@ -97,15 +236,117 @@ public:
   // TODO override SetAccess to limit time by [0, depth]
 };
 
+// Snapshots share unchanged square tiles of SEGMENT_TILE_SIZE x SEGMENT_TILE_SIZE points
+#define SEGMENT_TILE_SIZE 16
+
+/**
+ * Immutable copy of the segments of a SegmentSpace grid at some version.
+ * Snapshots are only read, so any number of threads can query one without locks.
+ * Points outside of the grid have no segments in snapshots.
+ */
+class SegmentSnapshot
+{
+public:
+  struct Tile
+  {
+    std::array<SegmentHolder, SEGMENT_TILE_SIZE * SEGMENT_TILE_SIZE> holders;
+    std::bitset<SEGMENT_TILE_SIZE * SEGMENT_TILE_SIZE> isPresent;
+  };
+
+private:
+  uint64_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t tilesPerRow;
+  ArrayType<std::shared_ptr<const Tile>> tiles;
+
+public:
+  SegmentSnapshot(uint64_t inVersion, uint32_t inWidth, uint32_t inHeight, ArrayType<std::shared_ptr<const Tile>> inTiles);
+
+  static inline size_t GetTileIndex(Point point, uint32_t tilesPerRow)
+  {
+    return point.x / SEGMENT_TILE_SIZE + (size_t) (point.y / SEGMENT_TILE_SIZE) * tilesPerRow;
+  }
+
+  static inline size_t GetIndexInTile(Point point)
+  {
+    return point.x % SEGMENT_TILE_SIZE + (size_t) (point.y % SEGMENT_TILE_SIZE) * SEGMENT_TILE_SIZE;
+  }
+
+  // Returns nullptr if the snapshot doesn't contain segments in the point
+  inline const SegmentHolder* Find(Point point) const
+  {
+    if (point.x < 0 || (uint32_t) point.x >= width || point.y < 0 || (uint32_t) point.y >= height)
+    {
+      return nullptr;
+    }
+
+    const Tile& tile = *tiles[GetTileIndex(point, tilesPerRow)];
+    size_t index = GetIndexInTile(point);
+    return tile.isPresent[index] ? &tile.holders[index] : nullptr;
+  }
+
+  bool ContainsSegmentsIn(Point point) const { return Find(point) != nullptr; }
+  const SegmentHolder& GetSegments(Point point) const;
+
+  // True if the tile is the same object in both snapshots, so its segments are equal
+  bool IsTileShared(const SegmentSnapshot& other, size_t tileIndex) const;
+
+  const ArrayType<std::shared_ptr<const Tile>>& GetTiles() const { return tiles; }
+  uint32_t GetTilesPerRow() const { return tilesPerRow; }
+  uint64_t GetVersion() const { return version; }
+  uint32_t GetWidth() const { return width; }
+  uint32_t GetHeight() const { return height; }
+};
+
+/**
+ * Publishes versions of a SegmentSpace for concurrent readers (RCU-style).
+ * A single writer changes the space as usual and calls Publish, which copies only the tiles
+ * changed since the previous version and shares the rest with it. Readers take the latest
+ * version with GetSnapshot from any thread and keep it alive as long as they use it.
+ */
+class SegmentSpacePublisher : public SegmentSpaceListener
+{
+private:
+  std::shared_ptr<SegmentSpace> space;
+  std::shared_ptr<const SegmentSnapshot> latest;
+  uint32_t tilesPerRow;
+  ArrayType<bool> isTileChanged;
+  bool isChanged = true;
+
+public:
+  SegmentSpacePublisher(std::shared_ptr<SegmentSpace> inSpace);
+  SegmentSpacePublisher(const SegmentSpacePublisher& other) = delete;
+  SegmentSpacePublisher& operator=(const SegmentSpacePublisher& other) = delete;
+  ~SegmentSpacePublisher();
+
+  virtual void OnSegmentsChanged(Point point) override;
+  virtual void OnTimeMoved(Time deltaTime) override;
+
+  // Writer only, returns the new version or the latest one if nothing has changed
+  std::shared_ptr<const SegmentSnapshot> Publish();
+
+  // Safe to call from any thread
+  std::shared_ptr<const SegmentSnapshot> GetSnapshot() const;
+};
+
+/**
+ * Reads MovingAI (HOG) maps. Rows are classified by a table indexed with the symbol,
+ * both LF and CRLF line endings are accepted.
+ */
 class SpaceReader
 {
 private:
-  MapType<char, Access> symbolToAccess;
+  std::array<Access, 256> symbolToAccess;
 
-  inline bool CheckHogFileStart(std::istream& file, uint32_t& width, uint32_t& height);
+  bool ReadHogHeader(const char*& data, const char* dataEnd, uint32_t& width, uint32_t& height) const;
 
 public:
   SpaceReader();
 
-  std::optional<RawSpace> FromHogFormat(std::istream& file);
+  std::optional<RawSpace> FromHogFormat(std::istream& file) const;
+  std::optional<RawSpace> FromHogFormat(const char* data, size_t size) const;
+
+  // Maps the file into memory when the platform supports it
+  std::optional<RawSpace> FromHogFile(const char* fileName) const;
 };
@@ -0,0 +1,300 @@
+#pragma once
+
+#include "pathfinder.h"
+#include "segment_moves.h"
+#include "search_result.h"
+#include "shapes.h"
+#include "space.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <memory>
+
+/**
+ * Segment moves which remember what the current search has read: footprints of the neighbors
+ * of expanded nodes and the hull of their segments which could be entered. The search gives
+ * the same result as long as reservations don't change the read footprints inside of the hulls.
+ */
+template<typename MoveSet>
+class RecordingSegmentMoves : public SegmentMoves<MoveSet>
+{
+protected:
+  struct ReadRecord
+  {
+    uint32_t stamp = 0;
+    Segment used = Segment::Invalid();
+  };
+
+  struct Recorder
+  {
+    RecordingSegmentMoves* moves;
+
+    inline void OnFootprintRead(Point point)
+    {
+      ReadRecord& record = moves->GetRecord(point);
+      if (record.stamp != moves->stamp)
+      {
+        record = { moves->stamp, Segment::Invalid() };
+      }
+    }
+
+    inline void OnSegmentUsed(Point point, Segment segment)
+    {
+      ReadRecord& record = moves->GetRecord(point);
+      if (record.used.IsValid())
+      {
+        segment = { std::min(record.used.start, segment.start), std::max(record.used.end, segment.end) };
+      }
+      record.used = segment;
+    }
+  };
+
+  uint32_t width;
+  uint32_t height;
+  ArrayType<ReadRecord> records;
+  MapType<Point, ReadRecord> outerRecords;
+  uint32_t stamp = 1;
+
+  inline ReadRecord& GetRecord(Point point)
+  {
+    if (point.x >= 0 && (uint32_t) point.x < width && point.y >= 0 && (uint32_t) point.y < height)
+    {
+      return records[point.x + (size_t) point.y * width];
+    }
+
+    return outerRecords[point];
+  }
+
+  inline const ReadRecord* FindRecord(Point point) const
+  {
+    if (point.x >= 0 && (uint32_t) point.x < width && point.y >= 0 && (uint32_t) point.y < height)
+    {
+      const ReadRecord& record = records[point.x + (size_t) point.y * width];
+      return record.stamp == stamp ? &record : nullptr;
+    }
+
+    auto found = outerRecords.find(point);
+    return found != outerRecords.end() && found->second.stamp == stamp ? &found->second : nullptr;
+  }
+
+public:
+  using SegmentMoves<MoveSet>::AppendValidMoves;
+
+  RecordingSegmentMoves(std::shared_ptr<ShapeSpace> inSpace, Time inDepth)
+    : SegmentMoves<MoveSet>(inSpace, inDepth)
+    , width(inSpace->GetWidth())
+    , height(inSpace->GetHeight())
+    , records((size_t) inSpace->GetWidth() * inSpace->GetHeight())
+  { }
+
+  // Forgets reads of the previous search
+  void StartRecording()
+  {
+    ++stamp;
+    outerRecords.clear();
+  }
+
+  /**
+   * True if the last search could change after the footprint of the point changes in the interval.
+   * Freed time can join any segment, so it matters wherever the footprint was read.
+   */
+  bool DependsOn(Point point, Segment interval, Access access) const
+  {
+    const ReadRecord* record = FindRecord(point);
+    if (!record) return false;
+    if (access == Access::Accessable) return true;
+
+    return record->used.IsValid() && (record->used & interval).IsValid();
+  }
+
+  virtual void AppendValidMoves(const Node<Area>& node, ArrayType<Move<Area>>& result) override
+  {
+    Recorder recorder{ this };
+    this->AppendAreaMoves(node, result, recorder);
+  }
+};
+
+struct PlanningTask
+{
+  Point start;
+  Point goal;
+  std::shared_ptr<Heuristic<Area>> heuristic;
+};
+
+struct PlanningResult
+{
+  bool isFound = false;
+  ArrayType<Node<Area>> path;
+  SearchResult<Area> stats;
+};
+
+/**
+ * Prioritized planning of shaped agents in a SpaceTime: an agent frees the reservation of its start,
+ * finds a windowed path to its goal and reserves the path, agents are planned in the order of the tasks.
+ *
+ * Agents are planned speculatively in batches of the size of the thread pool. Every worker keeps
+ * a replica of the space, all agents of a batch are planned in parallel against the reservations
+ * committed before the batch. Then paths are committed in priority order, a path is kept only if
+ * the reservations committed earlier in the batch don't overlap the footprints and times its search
+ * has read (see RecordingSegmentMoves), otherwise the agent is replanned. So the result is the same
+ * as of sequential planning.
+ */
+template<typename MoveSet>
+class SpeculativePlanner
+{
+protected:
+  struct Reservation
+  {
+    Area area;
+    Access access;
+  };
+
+  struct Worker
+  {
+    std::shared_ptr<SpaceTime> space;
+    std::shared_ptr<ShapeSpace> agentSpace;
+    std::shared_ptr<RecordingSegmentMoves<MoveSet>> moves;
+    std::unique_ptr<WindowedPathfinder<Area>> pathfinder;
+    size_t syncedChanges = 0;
+  };
+
+  std::shared_ptr<SpaceTime> space;
+  Shape shape;
+  std::shared_ptr<const RawSpace> footprintMap;
+  Time depth;
+
+  ArrayType<Worker> workers;
+  ArrayType<Reservation> changes;
+  ArrayType<Area> pathAreas;
+  size_t conflictsCount = 0;
+
+protected:
+  static void Apply(SegmentSpace& target, const Reservation& change)
+  {
+    if (change.access == Access::Accessable || target.ContainsSegmentsIn(change.area.point))
+    {
+      target.SetAccess(change.area, change.access);
+    }
+  }
+
+  void Sync(Worker& worker)
+  {
+    for (; worker.syncedChanges < changes.size(); ++worker.syncedChanges)
+    {
+      Apply(*worker.space, changes[worker.syncedChanges]);
+    }
+  }
+
+  // Plans the agent against the replica, the replica is left as it was
+  void Plan(Worker& worker, const PlanningTask& task, PlanningResult& result)
+  {
+    Area origin = { task.start, {0, depth} };
+    SegmentHolder startSegments = worker.space->GetSegments(task.start);
+    worker.space->SetAccess(origin, Access::Accessable);
+    worker.agentSpace->UpdateShape(task.start);
+    worker.agentSpace->UpdateShape(task.goal);
+
+    worker.moves->StartRecording();
+    worker.pathfinder->Reset(origin, task.heuristic);
+    Area destination = Area::FromDepth(task.goal, depth);
+    worker.pathfinder->FindCost(destination);
+
+    result.isFound = worker.pathfinder->IsCostFound(destination);
+    worker.pathfinder->CollectPath(destination, result.path);
+    result.stats = worker.pathfinder->GetStats();
+
+    worker.space->SetSegments(task.start, startSegments);
+  }
+
+  // True if a change after the worker's replica is under a footprint read by its last search
+  bool HasConflict(const Worker& worker) const
+  {
+    for (size_t i = worker.syncedChanges; i < changes.size(); ++i)
+    {
+      const Reservation& change = changes[i];
+      for (const Point& deltaPoint : shape.shape)
+      {
+        Point footprint = { change.area.point.x - deltaPoint.x, change.area.point.y - deltaPoint.y };
+        if (worker.moves->DependsOn(footprint, change.area.interval, change.access)) return true;
+      }
+    }
+
+    return false;
+  }
+
+  void Commit(const PlanningTask& task, const PlanningResult& result)
+  {
+    if (!result.isFound) return;
+
+    changes.push_back({ Area{ task.start, {0, depth} }, Access::Accessable });
+    Apply(*space, changes.back());
+
+    FromPathToFilledAreas(result.path, shape, pathAreas);
+    for (const Area& area : pathAreas)
+    {
+      changes.push_back({ area, Access::Inaccessable });
+      Apply(*space, changes.back());
+    }
+  }
+
+public:
+  SpeculativePlanner(std::shared_ptr<SpaceTime> inSpace, const Shape& inShape,
+    std::shared_ptr<const RawSpace> inFootprintMap, Time inDepth)
+    : space(inSpace)
+    , shape(inShape)
+    , footprintMap(inFootprintMap)
+    , depth(inDepth)
+  { }
+
+  /**
+   * Plans the tasks in order and reserves found paths in the space. An agent which path isn't found
+   * keeps the reservation of its start. Heuristics of the tasks are used by several threads,
+   * so they must not change during the search (see TrueDistanceHeuristic::FindAllCosts).
+   */
+  void PlanAll(const ArrayType<PlanningTask>& tasks, ArrayType<PlanningResult>& results, ThreadPool& threadPool)
+  {
+    results.clear();
+    results.resize(tasks.size());
+    changes.clear();
+    conflictsCount = 0;
+
+    // Replicas are copied from the space once, then they follow committed changes
+    workers.clear();
+    workers.resize(std::min(threadPool.GetThreadsCount(), tasks.size()));
+    threadPool.ParallelFor(workers.size(), [&](size_t workerIndex)
+    {
+      Worker& worker = workers[workerIndex];
+      worker.space = std::make_shared<SpaceTime>(*space);
+      worker.agentSpace = std::make_shared<ShapeSpace>(depth, worker.space, shape, footprintMap);
+      worker.moves = std::make_shared<RecordingSegmentMoves<MoveSet>>(worker.agentSpace, depth);
+      worker.pathfinder.reset(new WindowedPathfinder<Area>(worker.moves, Area{ Point{ 0, 0 }, {0, depth} }, nullptr, depth));
+    });
+
+    for (size_t batchStart = 0; batchStart < tasks.size(); batchStart += workers.size())
+    {
+      size_t batchSize = std::min(workers.size(), tasks.size() - batchStart);
+      threadPool.ParallelFor(batchSize, [&](size_t workerIndex)
+      {
+        Worker& worker = workers[workerIndex];
+        Sync(worker);
+        Plan(worker, tasks[batchStart + workerIndex], results[batchStart + workerIndex]);
+      });
+
+      for (size_t workerIndex = 0; workerIndex < batchSize; ++workerIndex)
+      {
+        Worker& worker = workers[workerIndex];
+        size_t taskIndex = batchStart + workerIndex;
+        if (HasConflict(worker))
+        {
+          conflictsCount++;
+          Sync(worker);
+          Plan(worker, tasks[taskIndex], results[taskIndex]);
+        }
+
+        Commit(tasks[taskIndex], results[taskIndex]);
+      }
+    }
+  }
+
+  // Number of speculative paths which were replanned during the last PlanAll
+  size_t GetConflictsCount() const { return conflictsCount; }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "search_types.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Fixed set of worker threads which run indexed tasks.
+ * Workers are kept between tasks, so a task doesn't pay for thread creation.
+ */
+class ThreadPool
+{
+private:
+  ArrayType<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable taskReady;
+  std::condition_variable taskDone;
+
+  std::function<void(size_t)> task;
+  size_t taskSize = 0;
+  std::atomic<size_t> nextIndex;
+  size_t activeWorkers = 0;
+  uint64_t taskGeneration = 0;
+  bool isStopping = false;
+
+  void WorkerLoop();
+  void RunIndices();
+
+public:
+  // The calling thread also runs tasks, so threadsCount includes it
+  explicit ThreadPool(unsigned threadsCount = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t GetThreadsCount() const;
+
+  /**
+   * Calls function(index) for every index in [0, count) and returns when all calls are finished.
+   * Calls can run concurrently, so the function must be safe to call from several threads.
+   */
+  void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+};
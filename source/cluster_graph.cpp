@@ -0,0 +1,558 @@
+#include "cluster_graph.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+const Point ClusterMoves::Source = { -1, -1 };
+
+ClusterMoves::ClusterMoves(std::shared_ptr<GridMoves> inMoves)
+  : moves(inMoves)
+{ }
+
+void ClusterMoves::SetCluster(Point inMin, Point inMax, const ArrayType<Move<Point>>& inSeeds)
+{
+  min = inMin;
+  max = inMax;
+  seeds = inSeeds;
+}
+
+ArrayType<Move<Point>> ClusterMoves::FindValidMoves(const Node<Point>& node)
+{
+  ArrayType<Move<Point>> result;
+  AppendValidMoves(node, result);
+  return result;
+}
+
+void ClusterMoves::AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& validMoves)
+{
+  if (node.cell == Source)
+  {
+    validMoves.insert(validMoves.end(), seeds.begin(), seeds.end());
+    return;
+  }
+
+  size_t kept = validMoves.size();
+  moves->AppendValidMoves(node, validMoves);
+  for (size_t i = kept; i < validMoves.size(); ++i)
+  {
+    Point destination = validMoves[i].destination;
+    if (destination.x < min.x || destination.x > max.x || destination.y < min.y || destination.y > max.y) continue;
+
+    validMoves[kept++] = validMoves[i];
+  }
+
+  validMoves.resize(kept);
+}
+
+/**
+ * Edges of the abstract graph: distances between entrances of a cluster, transitions
+ * between clusters and moves of the query endpoints, which are not entrances themselves.
+ */
+class ClusterGraph::AbstractMoves : public MoveComponent<Point>
+{
+public:
+  const ClusterGraph& graph;
+  MapType<Point, ArrayType<Move<Point>>> endpointMoves;
+
+  AbstractMoves(const ClusterGraph& inGraph)
+    : graph(inGraph)
+  { }
+
+  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override
+  {
+    ArrayType<Move<Point>> result;
+    AppendValidMoves(node, result);
+    return result;
+  }
+
+  virtual void AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& validMoves) override
+  {
+    auto entrance = graph.entranceIds.find(node.cell);
+    if (entrance != graph.entranceIds.end())
+    {
+      const Cluster& cluster = graph.clusters[graph.GetClusterIndex(node.cell)];
+      size_t entrancesCount = cluster.entrances.size();
+      size_t row = entrance->second * entrancesCount;
+      for (size_t i = 0; i < entrancesCount; ++i)
+      {
+        Time distance = cluster.distances[row + i];
+        if (i != entrance->second && distance >= 0)
+        {
+          validMoves.push_back({ distance, cluster.entrances[i], distance });
+        }
+      }
+
+      const ArrayType<Move<Point>>& exits = cluster.exits[entrance->second];
+      validMoves.insert(validMoves.end(), exits.begin(), exits.end());
+    }
+
+    auto endpoint = endpointMoves.find(node.cell);
+    if (endpoint != endpointMoves.end())
+    {
+      validMoves.insert(validMoves.end(), endpoint->second.begin(), endpoint->second.end());
+    }
+  }
+};
+
+ClusterGraph::ClusterGraph(std::shared_ptr<const RawSpace> inSpace, const Shape& inShape, const ArrayType<Move<Point>>& inMoves,
+  uint32_t inClusterSize)
+  : space(inSpace)
+  , shape(inShape)
+  , clusterSize(inClusterSize)
+  , clustersX((inSpace->GetWidth() + inClusterSize - 1) / inClusterSize)
+  , clustersY((inSpace->GetHeight() + inClusterSize - 1) / inClusterSize)
+  , moves(std::make_shared<GridMoves>(inSpace, inShape, inMoves))
+  , clusterMoves(std::make_shared<ClusterMoves>(moves))
+  , clusterSearch(clusterMoves, ClusterMoves::Source, std::make_shared<Heuristic<Point>>(ClusterMoves::Source))
+{
+  assert(clusterSize > 0);
+
+  for (const Move<Point>& move : inMoves)
+  {
+    maxMoveOffset = std::max(maxMoveOffset, std::max(std::abs(move.destination.x), std::abs(move.destination.y)));
+  }
+
+  // Moves only reach neighbor clusters
+  assert(maxMoveOffset <= (int) clusterSize);
+
+  clusterSearch.SetGridBounds(space->GetWidth(), space->GetHeight());
+
+  clusters.resize((size_t) clustersX * clustersY);
+  for (uint32_t y = 0; y < clustersY; ++y)
+  {
+    for (uint32_t x = 0; x < clustersX; ++x)
+    {
+      Cluster& cluster = clusters[x + (size_t) y * clustersX];
+      cluster.min = { (int) (x * clusterSize), (int) (y * clusterSize) };
+      cluster.max = { (int) std::min((x + 1) * clusterSize, space->GetWidth()) - 1,
+        (int) std::min((y + 1) * clusterSize, space->GetHeight()) - 1 };
+    }
+  }
+
+  for (uint32_t clusterIndex = 0; clusterIndex < clusters.size(); ++clusterIndex)
+  {
+    BuildTransitions(clusterIndex);
+  }
+
+  for (uint32_t clusterIndex = 0; clusterIndex < clusters.size(); ++clusterIndex)
+  {
+    BuildCluster(clusterIndex);
+  }
+}
+
+uint32_t ClusterGraph::GetClusterIndex(Point cell) const
+{
+  assert(Contains(cell));
+
+  return cell.x / clusterSize + (cell.y / clusterSize) * clustersX;
+}
+
+size_t ClusterGraph::GetIndexInCluster(Point cell) const
+{
+  const Cluster& cluster = clusters[GetClusterIndex(cell)];
+  return (cell.x - cluster.min.x) + (size_t) (cell.y - cluster.min.y) * (cluster.max.x - cluster.min.x + 1);
+}
+
+void ClusterGraph::BuildTransitions(uint32_t clusterIndex)
+{
+  struct Candidate
+  {
+    uint32_t target;
+    ClusterTransition transition;
+  };
+
+  Cluster& cluster = clusters[clusterIndex];
+  cluster.transitions.clear();
+
+  // Only cells near the border can leave the cluster
+  ArrayType<Candidate> candidates;
+  for (int y = cluster.min.y; y <= cluster.max.y; ++y)
+  {
+    for (int x = cluster.min.x; x <= cluster.max.x; ++x)
+    {
+      bool isInner = x - cluster.min.x >= maxMoveOffset && cluster.max.x - x >= maxMoveOffset
+        && y - cluster.min.y >= maxMoveOffset && cluster.max.y - y >= maxMoveOffset;
+      Point cell = { x, y };
+      if (isInner || !moves->IsValid(cell)) continue;
+
+      validMoves.clear();
+      moves->AppendValidMoves(Node<Point>(cell), validMoves);
+      for (const Move<Point>& move : validMoves)
+      {
+        uint32_t target = GetClusterIndex(move.destination);
+        if (target <= clusterIndex) continue;
+
+        candidates.push_back({ target, { cell, move.destination, move.cost } });
+      }
+    }
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& first, const Candidate& second)
+  {
+    return first.target < second.target;
+  });
+
+  auto isNear = [](Point first, Point second)
+  {
+    return std::abs(first.x - second.x) <= 1 && std::abs(first.y - second.y) <= 1;
+  };
+
+  // Moves into the same cluster between neighboring cells on both sides form one entrance
+  ArrayType<size_t> groups(candidates.size());
+  auto findGroup = [&](size_t candidate)
+  {
+    while (groups[candidate] != candidate)
+    {
+      candidate = groups[candidate] = groups[groups[candidate]];
+    }
+    return candidate;
+  };
+
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    groups[i] = i;
+    for (size_t j = i; j-- > 0 && candidates[j].target == candidates[i].target;)
+    {
+      if (isNear(candidates[i].transition.from, candidates[j].transition.from)
+        && isNear(candidates[i].transition.to, candidates[j].transition.to))
+      {
+        groups[findGroup(j)] = findGroup(i);
+      }
+    }
+  }
+
+  ArrayType<ArrayType<size_t>> entrances;
+  ArrayType<size_t> entranceOfGroup(candidates.size(), candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    size_t group = findGroup(i);
+    if (entranceOfGroup[group] == candidates.size())
+    {
+      entranceOfGroup[group] = entrances.size();
+      entrances.emplace_back();
+    }
+    entrances[entranceOfGroup[group]].push_back(i);
+  }
+
+  for (const ArrayType<size_t>& entrance : entrances)
+  {
+    // Width of the entrance in cells along the border
+    Point min = candidates[entrance.front()].transition.from;
+    Point max = min;
+    for (size_t candidate : entrance)
+    {
+      Point from = candidates[candidate].transition.from;
+      min = { std::min(min.x, from.x), std::min(min.y, from.y) };
+      max = { std::max(max.x, from.x), std::max(max.y, from.y) };
+    }
+
+    int width = std::max(max.x - min.x, max.y - min.y) + 1;
+    if (width < CLUSTER_WIDE_ENTRANCE)
+    {
+      cluster.transitions.push_back(candidates[entrance[entrance.size() / 2]].transition);
+    }
+    else
+    {
+      cluster.transitions.push_back(candidates[entrance.front()].transition);
+      cluster.transitions.push_back(candidates[entrance.back()].transition);
+    }
+  }
+}
+
+void ClusterGraph::BuildCluster(uint32_t clusterIndex)
+{
+  Cluster& cluster = clusters[clusterIndex];
+  for (const Point& entrance : cluster.entrances)
+  {
+    entranceIds.erase(entrance);
+  }
+  cluster.entrances.clear();
+  cluster.exits.clear();
+
+  auto addExit = [&](Point from, Point to, Time cost)
+  {
+    auto found = entranceIds.find(from);
+    uint32_t entranceId = found != entranceIds.end() ? found->second : (uint32_t) cluster.entrances.size();
+    if (found == entranceIds.end())
+    {
+      entranceIds[from] = entranceId;
+      cluster.entrances.push_back(from);
+      cluster.exits.emplace_back();
+    }
+
+    cluster.exits[entranceId].push_back({ cost, to, cost });
+  };
+
+  for (const ClusterTransition& transition : cluster.transitions)
+  {
+    addExit(transition.from, transition.to, transition.cost);
+  }
+
+  // Transitions into the cluster are kept by the neighbors with lower indices
+  int clusterX = clusterIndex % clustersX;
+  int clusterY = clusterIndex / clustersX;
+  for (int y = std::max(clusterY - 1, 0); y <= clusterY; ++y)
+  {
+    for (int x = std::max(clusterX - 1, 0); x <= std::min(clusterX + 1, (int) clustersX - 1); ++x)
+    {
+      uint32_t neighborIndex = x + y * clustersX;
+      if (neighborIndex >= clusterIndex) continue;
+
+      for (const ClusterTransition& transition : clusters[neighborIndex].transitions)
+      {
+        if (GetClusterIndex(transition.to) == clusterIndex) addExit(transition.to, transition.from, transition.cost);
+      }
+    }
+  }
+
+  // Distances are symmetric, so every search only looks for the entrances after its origin
+  size_t entrancesCount = cluster.entrances.size();
+  cluster.distances.assign(entrancesCount * entrancesCount, -1);
+  ArrayType<Point> targets;
+  ArrayType<Time> costs;
+  for (size_t i = 0; i < entrancesCount; ++i)
+  {
+    cluster.distances[i * entrancesCount + i] = 0;
+
+    targets.assign(cluster.entrances.begin() + i + 1, cluster.entrances.end());
+    StartClusterSearch(clusterIndex, { { 0, cluster.entrances[i], 0 } });
+    clusterSearch.FindCosts(targets, costs);
+    for (size_t j = i + 1; j < entrancesCount; ++j)
+    {
+      cluster.distances[i * entrancesCount + j] = costs[j - i - 1];
+      cluster.distances[j * entrancesCount + i] = costs[j - i - 1];
+    }
+  }
+}
+
+void ClusterGraph::StartClusterSearch(uint32_t clusterIndex, const ArrayType<Move<Point>>& seeds)
+{
+  const Cluster& cluster = clusters[clusterIndex];
+  clusterMoves->SetCluster(cluster.min, cluster.max, seeds);
+  clusterSearch.Reset(ClusterMoves::Source);
+}
+
+void ClusterGraph::SearchCluster(uint32_t clusterIndex, const ArrayType<Move<Point>>& seeds)
+{
+  StartClusterSearch(clusterIndex, seeds);
+  clusterSearch.SettleAll();
+}
+
+Time ClusterGraph::FindClusterCost(Point cell) const
+{
+  return clusterSearch.IsCostSettled(cell) ? clusterSearch.GetCost(cell) : -1;
+}
+
+void ClusterGraph::UpdateCells(const ArrayType<Point>& cells)
+{
+  // Footprints which cover a changed cell
+  SetType<uint32_t> changedClusters;
+  for (const Point& cell : cells)
+  {
+    for (const Point& deltaPoint : shape.shape)
+    {
+      Point footprint = { cell.x - deltaPoint.x, cell.y - deltaPoint.y };
+      if (Contains(footprint)) changedClusters.insert(GetClusterIndex(footprint));
+    }
+  }
+
+  SetType<uint32_t> affectedClusters;
+  for (uint32_t clusterIndex : changedClusters)
+  {
+    int clusterX = clusterIndex % clustersX;
+    int clusterY = clusterIndex / clustersX;
+    for (int y = std::max(clusterY - 1, 0); y <= std::min(clusterY + 1, (int) clustersY - 1); ++y)
+    {
+      for (int x = std::max(clusterX - 1, 0); x <= std::min(clusterX + 1, (int) clustersX - 1); ++x)
+      {
+        affectedClusters.insert(x + y * clustersX);
+      }
+    }
+  }
+
+  // Entrances of a cluster depend on transitions of its neighbors
+  for (uint32_t clusterIndex : affectedClusters)
+  {
+    BuildTransitions(clusterIndex);
+  }
+
+  for (uint32_t clusterIndex : affectedClusters)
+  {
+    BuildCluster(clusterIndex);
+  }
+
+  ++version;
+}
+
+void ClusterGraph::ConnectOrigin(Point origin, AbstractMoves& abstractMoves)
+{
+  uint32_t clusterIndex = GetClusterIndex(origin);
+  SearchCluster(clusterIndex, { { 0, origin, 0 } });
+
+  ArrayType<Move<Point>>& originMoves = abstractMoves.endpointMoves[origin];
+  for (const Point& entrance : clusters[clusterIndex].entrances)
+  {
+    Time cost = FindClusterCost(entrance);
+    if (cost > 0) originMoves.push_back({ cost, entrance, cost });
+  }
+}
+
+void ClusterGraph::ConnectGoal(Point goal, AbstractMoves& abstractMoves)
+{
+  uint32_t clusterIndex = GetClusterIndex(goal);
+  SearchCluster(clusterIndex, { { 0, goal, 0 } });
+
+  for (const Point& entrance : clusters[clusterIndex].entrances)
+  {
+    Time cost = FindClusterCost(entrance);
+    if (cost > 0) abstractMoves.endpointMoves[entrance].push_back({ cost, goal, cost });
+  }
+}
+
+bool ClusterGraph::FindPath(Point from, Point to, ArrayType<Node<Point>>& path)
+{
+  path.clear();
+  if (!moves->IsValid(from) || !moves->IsValid(to)) return false;
+
+  std::shared_ptr<AbstractMoves> abstractMoves = std::make_shared<AbstractMoves>(*this);
+  ConnectGoal(to, *abstractMoves);
+  ConnectOrigin(from, *abstractMoves);
+
+  // Endpoints of one cluster are also connected directly
+  if (GetClusterIndex(from) == GetClusterIndex(to))
+  {
+    Time cost = FindClusterCost(to);
+    if (cost > 0) abstractMoves->endpointMoves[from].push_back({ cost, to, cost });
+  }
+
+  Pathfinder<Point> abstractSearch(abstractMoves, from, std::make_shared<EuclideanHeuristic>(to));
+  abstractSearch.SettleCost(to);
+  if (!abstractSearch.IsCostSettled(to)) return false;
+
+  ArrayType<Node<Point>> abstractPath;
+  abstractSearch.CollectPath(to, abstractPath);
+
+  path.push_back(abstractPath.front());
+  ArrayType<Node<Point>> clusterPath;
+  for (size_t i = 1; i < abstractPath.size(); ++i)
+  {
+    Point previous = abstractPath[i - 1].cell;
+    Point next = abstractPath[i].cell;
+    uint32_t clusterIndex = GetClusterIndex(previous);
+    if (clusterIndex != GetClusterIndex(next))
+    {
+      path.push_back(abstractPath[i]);
+      continue;
+    }
+
+    // The first node of the cluster path is the source, the second one is the previous abstract node
+    StartClusterSearch(clusterIndex, { { 0, previous, 0 } });
+    clusterSearch.SettleCost(next);
+    clusterSearch.CollectPath(next, clusterPath);
+    for (size_t j = 2; j < clusterPath.size(); ++j)
+    {
+      clusterPath[j].minTime += abstractPath[i - 1].minTime;
+      path.push_back(clusterPath[j]);
+    }
+  }
+
+  return true;
+}
+
+void ClusterGraph::FindEntranceCosts(Point goal, MapType<Point, Time>& costs)
+{
+  costs.clear();
+  if (!moves->IsValid(goal)) return;
+
+  // Moves are symmetric, so costs from the goal are costs to it
+  std::shared_ptr<AbstractMoves> abstractMoves = std::make_shared<AbstractMoves>(*this);
+  ConnectOrigin(goal, *abstractMoves);
+
+  Pathfinder<Point> abstractSearch(abstractMoves, goal, std::make_shared<Heuristic<Point>>(goal));
+  abstractSearch.SettleAll();
+
+  for (const auto& [entrance, entranceId] : entranceIds)
+  {
+    if (abstractSearch.IsCostSettled(entrance)) costs[entrance] = abstractSearch.GetCost(entrance);
+  }
+}
+
+void ClusterGraph::FindCellCosts(uint32_t clusterIndex, Point goal, const MapType<Point, Time>& entranceCosts,
+  ArrayType<Time>& costs)
+{
+  const Cluster& cluster = clusters[clusterIndex];
+
+  ArrayType<Move<Point>> seeds;
+  for (const Point& entrance : cluster.entrances)
+  {
+    auto found = entranceCosts.find(entrance);
+    if (found != entranceCosts.end()) seeds.push_back({ found->second, entrance, found->second });
+  }
+  if (moves->IsValid(goal) && GetClusterIndex(goal) == clusterIndex)
+  {
+    seeds.push_back({ 0, goal, 0 });
+  }
+
+  SearchCluster(clusterIndex, seeds);
+
+  costs.assign((size_t) (cluster.max.x - cluster.min.x + 1) * (cluster.max.y - cluster.min.y + 1), -1);
+  for (int y = cluster.min.y; y <= cluster.max.y; ++y)
+  {
+    for (int x = cluster.min.x; x <= cluster.max.x; ++x)
+    {
+      costs[GetIndexInCluster({ x, y })] = FindClusterCost({ x, y });
+    }
+  }
+}
+
+HierarchicalHeuristic::HierarchicalHeuristic(std::shared_ptr<ClusterGraph> inGraph, Point inGoal)
+  : Heuristic(inGoal)
+  , graph(inGraph)
+  , goal(inGoal)
+  , version(inGraph->GetVersion())
+  , clusterCosts(inGraph->GetClustersCount())
+{
+  graph->FindEntranceCosts(goal, entranceCosts);
+}
+
+bool HierarchicalHeuristic::IsCostFound(Point to) const
+{
+  if (!graph->Contains(to)) return false;
+
+  const ArrayType<Time>& costs = clusterCosts[graph->GetClusterIndex(to)];
+  return !costs.empty() && costs[graph->GetIndexInCluster(to)] >= 0;
+}
+
+Time HierarchicalHeuristic::GetCost(Point to) const
+{
+  assert(IsCostFound(to));
+
+  return clusterCosts[graph->GetClusterIndex(to)][graph->GetIndexInCluster(to)];
+}
+
+void HierarchicalHeuristic::FindCost(Point to)
+{
+  if (!graph->Contains(to)) return;
+
+  // Entrances and distances of the clusters could change
+  if (version != graph->GetVersion())
+  {
+    version = graph->GetVersion();
+    graph->FindEntranceCosts(goal, entranceCosts);
+    for (ArrayType<Time>& costs : clusterCosts)
+    {
+      costs.clear();
+    }
+  }
+
+  uint32_t clusterIndex = graph->GetClusterIndex(to);
+  if (clusterCosts[clusterIndex].empty())
+  {
+    graph->FindCellCosts(clusterIndex, goal, entranceCosts, clusterCosts[clusterIndex]);
+  }
+}
+
+Point HierarchicalHeuristic::GetOrigin() const
+{
+  return goal;
+}
@@ -0,0 +1,31 @@
+#include "grid_moves.h"
+
+GridMoves::GridMoves(std::shared_ptr<const RawSpace> inSpace, const Shape& inShape, const ArrayType<Move<Point>>& inMoves)
+  : space(inSpace)
+  , shape(inShape)
+  , moves(inMoves)
+{ }
+
+bool GridMoves::IsValid(Point point) const
+{
+  return space->AreAllAccessable(point, shape.shape);
+}
+
+ArrayType<Move<Point>> GridMoves::FindValidMoves(const Node<Point>& node)
+{
+  ArrayType<Move<Point>> result;
+  AppendValidMoves(node, result);
+  return result;
+}
+
+void GridMoves::AppendValidMoves(const Node<Point>& node, ArrayType<Move<Point>>& validMoves)
+{
+  for (const Move<Point>& move : moves)
+  {
+    Point destination = node.cell + move.destination;
+    if (IsValid(destination))
+    {
+      validMoves.push_back({ move.cost, destination, move.cost });
+    }
+  }
+}
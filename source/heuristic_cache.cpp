@@ -0,0 +1,119 @@
+#include "heuristic_cache.h"
+#include <cassert>
+#include <unordered_set>
+
+TrueDistanceHeuristic::TrueDistanceHeuristic(std::shared_ptr<GridMoves> inMoves, Point inGoal, uint32_t width, uint32_t height)
+  : Heuristic(inGoal)
+  , goal(inGoal)
+  , reverseSearch(inMoves, inGoal, std::make_shared<Heuristic<Point>>(inGoal))
+{
+  reverseSearch.SetGridBounds(width, height);
+}
+
+bool TrueDistanceHeuristic::IsCostFound(Point to) const
+{
+  return reverseSearch.IsCostSettled(to);
+}
+
+Time TrueDistanceHeuristic::GetCost(Point to) const
+{
+  return reverseSearch.GetCost(to);
+}
+
+void TrueDistanceHeuristic::FindCost(Point to)
+{
+  // A finished search isn't touched, so it can be read by several searches at once
+  if (isFinished) return;
+
+  reverseSearch.SettleCost(to);
+}
+
+Point TrueDistanceHeuristic::GetOrigin() const
+{
+  return goal;
+}
+
+void TrueDistanceHeuristic::FindAllCosts()
+{
+  reverseSearch.SettleAll();
+  isFinished = true;
+}
+
+HeuristicCache::HeuristicCache(std::shared_ptr<const RawSpace> inSpace, const ArrayType<Move<Point>>& inMoves, size_t inCapacity)
+  : space(inSpace)
+  , moves(inMoves)
+  , capacity(inCapacity)
+{
+  assert(capacity > 0);
+}
+
+std::shared_ptr<TrueDistanceHeuristic> HeuristicCache::Get(Point goal, const Shape& shape)
+{
+  DistanceTableKey key{ goal, shape };
+
+  auto found = entries.find(key);
+  if (found != entries.end())
+  {
+    found->second.lastUse = ++useCounter;
+    return found->second.heuristic;
+  }
+
+  if (entries.size() >= capacity)
+  {
+    EvictLeastRecentlyUsed();
+  }
+
+  std::shared_ptr<GridMoves> shapeMoves = std::make_shared<GridMoves>(space, shape, moves);
+  std::shared_ptr<TrueDistanceHeuristic> heuristic = std::make_shared<TrueDistanceHeuristic>(
+    shapeMoves, goal, space->GetWidth(), space->GetHeight());
+
+  entries[key] = CacheEntry{ heuristic, ++useCounter };
+  return heuristic;
+}
+
+ArrayType<std::shared_ptr<TrueDistanceHeuristic>> HeuristicCache::Precompute(
+  const ArrayType<DistanceTableKey>& keys, ThreadPool& threadPool)
+{
+  ArrayType<std::shared_ptr<TrueDistanceHeuristic>> result;
+  ArrayType<TrueDistanceHeuristic*> uniqueHeuristics;
+  std::unordered_set<TrueDistanceHeuristic*> seenHeuristics;
+
+  // The cache itself isn't thread-safe, so heuristics are taken sequentially
+  for (const DistanceTableKey& key : keys)
+  {
+    result.push_back(Get(key.goal, key.shape));
+    if (seenHeuristics.insert(result.back().get()).second)
+    {
+      uniqueHeuristics.push_back(result.back().get());
+    }
+  }
+
+  threadPool.ParallelFor(uniqueHeuristics.size(), [&uniqueHeuristics](size_t index)
+  {
+    uniqueHeuristics[index]->FindAllCosts();
+  });
+
+  return result;
+}
+
+void HeuristicCache::EvictLeastRecentlyUsed()
+{
+  auto leastRecent = entries.begin();
+  for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+  {
+    if (entry->second.lastUse < leastRecent->second.lastUse)
+    {
+      leastRecent = entry;
+    }
+  }
+
+  if (leastRecent != entries.end())
+  {
+    entries.erase(leastRecent);
+  }
+}
+
+size_t HeuristicCache::Size() const
+{
+  return entries.size();
+}
@@ -0,0 +1,202 @@
+#include "jump_point_moves.h"
+#include "move_sets.h"
+#include "bits.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+  inline int Sign(int value)
+  {
+    return (value > 0) - (value < 0);
+  }
+}
+
+JumpPointMoves::JumpPointMoves(std::shared_ptr<const RawSpace> inSpace, Point inGoal)
+  : space(inSpace)
+  , goal(inGoal)
+{ }
+
+bool JumpPointMoves::JumpHorizontal(Point from, int dx, Point& jumpPoint) const
+{
+  const int y = from.y;
+  const uint64_t candidates = LowBitsMask(63);
+
+  if (dx > 0)
+  {
+    for (int first = from.x + 1; ; first += 63)
+    {
+      // Bit i is the cell first - 1 + i, the first bit is the cell behind the first candidate
+      uint64_t row = space->GetRowBits(y, first - 1, 64);
+      uint64_t above = space->GetRowBits(y - 1, first - 1, 64);
+      uint64_t below = space->GetRowBits(y + 1, first - 1, 64);
+
+      // After the shift bit i is the cell first + i
+      uint64_t blocked = ~(row >> 1) & candidates;
+      uint64_t stops = ((above & ~(above << 1)) | (below & ~(below << 1))) >> 1 & candidates;
+      if (goal.y == y && goal.x >= first && goal.x < first + 63)
+      {
+        stops |= uint64_t(1) << (goal.x - first);
+      }
+
+      if (blocked) stops &= LowBitsMask(CountTrailingZeros(blocked));
+      if (stops)
+      {
+        jumpPoint = { first + (int) CountTrailingZeros(stops), y };
+        return true;
+      }
+      if (blocked) return false;
+    }
+  }
+
+  for (int last = from.x - 1; ; last -= 63)
+  {
+    // Bit i is the cell last - 62 + i, the highest bit is the cell behind the first candidate
+    int first = last - 62;
+    uint64_t row = space->GetRowBits(y, first, 64);
+    uint64_t above = space->GetRowBits(y - 1, first, 64);
+    uint64_t below = space->GetRowBits(y + 1, first, 64);
+
+    uint64_t blocked = ~row & candidates;
+    uint64_t stops = ((above & ~(above >> 1)) | (below & ~(below >> 1))) & candidates;
+    if (goal.y == y && goal.x >= first && goal.x <= last)
+    {
+      stops |= uint64_t(1) << (goal.x - first);
+    }
+
+    if (blocked) stops &= ~LowBitsMask(FindHighestBit(blocked) + 1);
+    if (stops)
+    {
+      jumpPoint = { first + (int) FindHighestBit(stops), y };
+      return true;
+    }
+    if (blocked) return false;
+  }
+}
+
+bool JumpPointMoves::JumpStraight(Point from, int dx, int dy, Point& jumpPoint) const
+{
+  if (dy == 0)
+  {
+    return JumpHorizontal(from, dx, jumpPoint);
+  }
+
+  for (Point current = from; ; )
+  {
+    int x = current.x + dx;
+    int y = current.y + dy;
+    if (!IsFree(x, y)) return false;
+
+    current = { x, y };
+    jumpPoint = current;
+    if (current == goal) return true;
+
+    // A neighbor is forced when the cell behind it is blocked, so it can't be reached around this cell
+    if (dx != 0)
+    {
+      if ((IsFree(x, y - 1) && !IsFree(x - dx, y - 1)) || (IsFree(x, y + 1) && !IsFree(x - dx, y + 1))) return true;
+    }
+    else
+    {
+      if ((IsFree(x - 1, y) && !IsFree(x - 1, y - dy)) || (IsFree(x + 1, y) && !IsFree(x + 1, y - dy))) return true;
+    }
+  }
+}
+
+bool JumpPointMoves::Jump(Point from, int dx, int dy, Point& jumpPoint) const
+{
+  if (dx == 0 || dy == 0)
+  {
+    return JumpStraight(from, dx, dy, jumpPoint);
+  }
+
+  for (Point current = from; ; )
+  {
+    // Diagonal moves don't cut corners
+    if (!IsFree(current.x + dx, current.y) || !IsFree(current.x, current.y + dy) || !IsFree(current.x + dx, current.y + dy))
+    {
+      return false;
+    }
+
+    current = { current.x + dx, current.y + dy };
+    jumpPoint = current;
+    if (current == goal) return true;
+
+    Point straightJumpPoint;
+    if (JumpStraight(current, dx, 0, straightJumpPoint) || JumpStraight(current, 0, dy, straightJumpPoint))
+    {
+      return true;
+    }
+  }
+}
+
+void JumpPointMoves::AppendJump(Point from, int dx, int dy, ArrayType<Move<Point>>& validMoves) const
+{
+  Point jumpPoint;
+  if (!Jump(from, dx, dy, jumpPoint)) return;
+
+  int deltaX = std::abs(jumpPoint.x - from.x);
+  int deltaY = std::abs(jumpPoint.y - from.y);
+  int diagonalSteps = std::min(deltaX, deltaY);
+  Time cost = diagonalSteps * DIAGONAL_MOVE_COST + (std::max(deltaX, deltaY) - diagonalSteps);
+
+  validMoves.push_back({ cost, jumpPoint, cost });
+}
+
+ArrayType<Move<Point>> JumpPointMoves::FindValidMoves(const Node<Point>& node)
+{
+  ArrayType<Move<Point>> result;
+  AppendSuccessors(node, nullptr, result);
+  return result;
+}
+
+void JumpPointMoves::AppendSuccessors(const Node<Point>& node, const Node<Point>* parent, ArrayType<Move<Point>>& validMoves)
+{
+  Point from = node.cell;
+
+  if (!parent)
+  {
+    for (const GridMoveOffset& move : EightConnectedNoCornerCuttingMoves::Moves)
+    {
+      AppendJump(from, move.x, move.y, validMoves);
+    }
+    return;
+  }
+
+  int dx = Sign(from.x - parent->cell.x);
+  int dy = Sign(from.y - parent->cell.y);
+
+  if (dx != 0 && dy != 0)
+  {
+    AppendJump(from, 0, dy, validMoves);
+    AppendJump(from, dx, 0, validMoves);
+    AppendJump(from, dx, dy, validMoves);
+  }
+  else if (dx != 0)
+  {
+    AppendJump(from, dx, 0, validMoves);
+
+    // A side is forced when the cell behind it is blocked, see JumpStraight
+    for (int side : { -1, 1 })
+    {
+      if (IsFree(from.x, from.y + side) && !IsFree(from.x - dx, from.y + side))
+      {
+        AppendJump(from, 0, side, validMoves);
+        AppendJump(from, dx, side, validMoves);
+      }
+    }
+  }
+  else
+  {
+    AppendJump(from, 0, dy, validMoves);
+
+    for (int side : { -1, 1 })
+    {
+      if (IsFree(from.x + side, from.y) && !IsFree(from.x + side, from.y - dy))
+      {
+        AppendJump(from, side, 0, validMoves);
+        AppendJump(from, side, dy, validMoves);
+      }
+    }
+  }
+}
@@ -1,4 +1,7 @@
 #include "pathfinder.h"
+#include "heuristic_cache.h"
+#include "move_sets.h"
+#include "speculative_planner.h"
 #include "space.h"
 #include "hog2-utils/ScenarioLoader.h"
 #include <iostream>
@@ -7,87 +10,21 @@
 #include <iomanip>
 #include <cmath>
 
-class MovesTestSegment : public MoveComponent<Area>, public MoveComponent<Point>
-{
-protected:
-  Time depth;
-  ShapeSpace* space;
-  ArrayType<Move<Point>> moves;
-
-public:
-  virtual ArrayType<Move<Area>> FindValidMoves(const Node<Area>& node) override
-  {
-    ArrayType<Move<Area>> result;
-    Area origin = node.cell;
-
-    Segment moveAvailable{ node.minTime, node.cell.interval.end };
-    if (node.cell.interval.end >= depth)
-    {
-      result.push_back({ moveAvailable.GetLength(), Area{origin, {depth, depth}}, 0 });
-    }
-
-    for (Move<Point> move : moves)
-    {
-      Point destinationPoint = origin.point + move.destination;
-
-      space->UpdateShape(destinationPoint);
-      if (!space->ContainsSegmentsIn(destinationPoint)) continue;
-      const SegmentHolder& segHolder = space->GetSegments(destinationPoint);
-
-      for (Segment segment : segHolder)
-      {
-        // TODO mechanism to check collision with other cells (example: move from (0, 0) to (5, 5)
-        Segment both = moveAvailable & segment;
-
-        if (both.IsValid() && both.GetLength() >= move.cost)
-        {
-          Time overallCost = both.start + move.cost - node.minTime;
-          result.push_back({ overallCost, Area{destinationPoint, segment}, move.cost });
-        }
-      }
-    }
-
-    return result;
-  }
-
-  virtual ArrayType<Move<Point>> FindValidMoves(const Node<Point>& node) override
-  {
-    ArrayType<Move<Point>> result;
-    Point origin = node.cell;
-
-    for (Move<Point> move : moves)
-    {
-      Point destinationPoint = origin + move.destination;
-
-      space->UpdateShape(destinationPoint);
-      if (!space->ContainsSegmentsIn(destinationPoint)) continue;
-
-      const SegmentHolder& segHolder = space->GetSegments(destinationPoint);
-      if (segHolder.end() == segHolder.begin()) continue;
-
-      // TODO mechanism to check collision with other cells (example: move from (0, 0) to (5, 5)
-      result.push_back({ move.cost, destinationPoint, move.cost });
-    }
-
-    return result;
-  }
-
-  MovesTestSegment(ArrayType<Move<Point>>& inmoves, ShapeSpace* inspace, Time inDepth)
-    : space(inspace)
-    , moves(inmoves)
-    , depth(inDepth)
-  {}
-};
+#define HEURISTIC_CACHE_CAPACITY 256
 
 class Mission
 {
   ScenarioLoader loader;
+  std::shared_ptr<RawSpace> baseSpace;
   std::shared_ptr<SpaceTime> space;
   std::ofstream animation;
+  std::ofstream statistics;
   Time depth = 0;
   int agentsNum = 0;
 
-  std::shared_ptr<ShapeSpace> agentSpace;
+  std::shared_ptr<const RawSpace> agentFootprints;
+  std::shared_ptr<HeuristicCache> heuristicCache;
+  ThreadPool threadPool;
   Shape agentShape = { ArrayType<Point>{ {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0} } };
   double agentPrintRad = 1;
 
@@ -106,20 +43,28 @@ public:
     return 0;
   }
 
+  int InitStatistics(const char* statisticsFileName)
+  {
+    statistics.open(statisticsFileName, std::ios_base::out);
+    if (!statistics.is_open()) return 1;
+
+    statistics << "agent,";
+    SearchResult<Area>::WriteCsvHeader(statistics);
+    return 0;
+  }
+
   int ReadSpace(Time inDepth, const char* spaceFileName)
   {
     if (!animation.is_open()) return 1;
 
     SpaceReader reader;
-    std::ifstream spaceFile(spaceFileName);
-    if (!spaceFile.is_open()) return 1;
-
-    std::optional<RawSpace> rawSpace = reader.FromHogFormat(spaceFile);
+    std::optional<RawSpace> rawSpace = reader.FromHogFile(spaceFileName);
     if (!rawSpace.has_value()) return 1;
 
     depth = inDepth;
+    baseSpace = std::make_shared<RawSpace>(rawSpace.value());
     space = std::make_shared<SpaceTime>(inDepth, rawSpace.value());
-    agentSpace = std::make_shared<ShapeSpace>(inDepth, space, agentShape);
+    agentFootprints = std::make_shared<RawSpace>(ErodeByShape(*baseSpace, agentShape));
 
     animation << rawSpace.value().GetWidth() << "\n";
     for (int i = 0; i < (int)rawSpace.value().GetHeight(); ++i)
@@ -205,65 +150,54 @@ public:
 
   int SolveCycle()
   {
-    ArrayType<Move<Point>> moves =
+    using AgentMoves = EightConnectedMoves;
+
+    if (!heuristicCache)
     {
-      Move<Point>{ 1, {0, 1}},
-      Move<Point>{ 1, {0, -1}},
-      Move<Point>{ 1, {1, 0}},
-      Move<Point>{ 1, {-1, 0}},
-      Move<Point>{ std::sqrt(2.f), {1, 1}},
-      Move<Point>{ std::sqrt(2.f), {-1, -1}},
-      Move<Point>{ std::sqrt(2.f), {1, -1}},
-      Move<Point>{ std::sqrt(2.f), {-1, 1}},
-    };
+      heuristicCache = std::make_shared<HeuristicCache>(baseSpace, MakeMoves<AgentMoves>(), HEURISTIC_CACHE_CAPACITY);
+    }
 
+    // Planar heuristics don't depend on reservations, so they are computed in parallel before planning
+    ArrayType<DistanceTableKey> heuristicKeys;
     for (int i = 0; i < agentsNum; ++i)
     {
-      // TODO add test when agent stands on one place
-      std::cout << "Planning agent " << i << "... ";
+      Experiment agent = loader.GetNthExperiment(i);
+      heuristicKeys.push_back({ Point{ agent.GetGoalX(), agent.GetGoalY() }, agentShape });
+    }
+    ArrayType<std::shared_ptr<TrueDistanceHeuristic>> agentHeuristics = heuristicCache->Precompute(heuristicKeys, threadPool);
 
-      // Prepare agent
+    ArrayType<PlanningTask> tasks;
+    for (int i = 0; i < agentsNum; ++i)
+    {
       Experiment agent = loader.GetNthExperiment(i);
       Point start = { agent.GetStartX(), agent.GetStartY() };
       Point goal = { agent.GetGoalX(), agent.GetGoalY() };
-      Area origin = { start, {0, depth} };
+      tasks.push_back({ start, goal, std::make_shared<SpaceAdapter<Point, Area>>(agentHeuristics[i]) });
+    }
 
-      // Prepare agent space
-      /*
-      for (Point deltaPoint : agentShape.shape)
-      {
-        space->SetAccess({ start + deltaPoint, {0, depth} }, Access::Accessable);
-      }*/
+    // Agents are planned in parallel, the paths are the same as if they were planned one by one
+    SpeculativePlanner<AgentMoves> planner(space, agentShape, agentFootprints, depth);
+    ArrayType<PlanningResult> results;
+    planner.PlanAll(tasks, results, threadPool);
+
+    for (int i = 0; i < agentsNum; ++i)
+    {
+      // TODO add test when agent stands on one place
+      std::cout << "Planning agent " << i << "... ";
 
-      space->SetAccess({ start, {0, depth} }, Access::Accessable);
-      agentSpace = std::make_shared<ShapeSpace>(depth, space, agentShape);
-      agentSpace->UpdateShape(start);
-      agentSpace->UpdateShape(goal);
-
-      // Prepare pathfinding
-      std::shared_ptr<MovesTestSegment> movesComponent(new MovesTestSegment(moves, agentSpace.get(), depth));
-      std::shared_ptr<EuclideanHeuristic> simpleHeurisitc(new EuclideanHeuristic(start));
-      std::shared_ptr<Pathfinder<Point>> planeSearch(new Pathfinder<Point>(movesComponent, goal, simpleHeurisitc));
-      std::shared_ptr<Heuristic<Area>> h(new SpaceAdapter<Point, Area>(planeSearch));
-      WindowedPathfinder<Area> pathfinder(movesComponent, origin, h, depth);
-      Area destination = Area::FromDepth(goal, depth);
-
-      // Execute pathfinding
-      pathfinder.FindCost(destination);
-      if (!pathfinder.IsCostFound(destination))
+      if (!results[i].isFound)
       {
         std::cout << "failed to find agent with id = " << i << "\n";
         return 1;
       }
 
-      ArrayType<Node<Area>> path;
-      pathfinder.CollectPath(destination, path);
-
-      ArrayType<Area> inaccessableParts;
-      FromPathToFilledAreas(path, agentShape, inaccessableParts);
-      space->MakeAreasInaccessable(inaccessableParts);
+      if (statistics.is_open())
+      {
+        statistics << i << ",";
+        results[i].stats.WriteCsvRow(statistics);
+      }
 
-      PrintAgentPath(i, path);
+      PrintAgentPath(i, results[i].path);
     }
 
     return 0;
@@ -281,6 +215,12 @@ int main()
   }
   std::cout << "Animation init ok\n";
 
+  if (mission.InitStatistics(TEST_DATA_PATH "/statistics.csv"))
+  {
+    std::cout << "Statistics init failed\n";
+    return 1;
+  }
+
 
   if (mission.ReadSpace(100, TEST_DATA_PATH "/ost003d.map"))
   {
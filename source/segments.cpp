@@ -64,33 +64,69 @@ Segment Segment::Invalid()
   return Segment{ 1, -1 }; 
 }
 
+size_t SegmentHolder::LowerBound(Segment segment) const
+{
+  return std::lower_bound(segments.begin(), segments.end(), segment) - segments.begin();
+}
+
+size_t SegmentHolder::UpperBound(Segment segment) const
+{
+  return std::upper_bound(segments.begin(), segments.end(), segment) - segments.begin();
+}
+
 bool SegmentHolder::Contains(Segment segment) const
 {
-  return (segments.count(segment) > 0);
+  size_t candidate = LowerBound(segment);
+  return candidate < segments.Size() && !(segment < segments[candidate]);
 }
 
 void SegmentHolder::AddSegment(Segment newSegment)
 {
-  const_iterator unionCandidate = segments.lower_bound({ newSegment.start, newSegment.start });
-  while (unionCandidate != segments.end() && (newSegment & *unionCandidate).IsValid())
+  size_t firstUnited = LowerBound({ newSegment.start, newSegment.start });
+  size_t lastUnited = firstUnited;
+  while (lastUnited < segments.Size() && (newSegment & segments[lastUnited]).IsValid())
   {
-    newSegment = newSegment | *unionCandidate;
-    segments.erase(unionCandidate++);
+    newSegment = newSegment | segments[lastUnited];
+    ++lastUnited;
   }
 
-  segments.insert(newSegment);
+  if (firstUnited == lastUnited)
+  {
+    segments.Insert(firstUnited, newSegment);
+    return;
+  }
+
+  segments[firstUnited] = newSegment;
+  segments.Erase(firstUnited + 1, lastUnited);
 }
 
 void SegmentHolder::RemoveSegment(Segment removal)
 {
-  const_iterator removalCandidate = segments.upper_bound({ removal.start, removal.start });
-  while (removalCandidate != segments.end() && (removal & *removalCandidate).IsValid())
+  size_t removalCandidate = UpperBound({ removal.start, removal.start });
+  while (removalCandidate < segments.Size() && (removal & segments[removalCandidate]).IsValid())
   {
-    auto difference = (*removalCandidate) - removal;
-    segments.erase(removalCandidate++);
-    for (auto& newSegment : difference)
+    // Same as (candidate - removal), but without a temporary array
+    Segment candidate = segments[removalCandidate];
+    Segment commonSegment = candidate & removal;
+    Segment before{ candidate.start, commonSegment.start };
+    Segment after{ commonSegment.end, candidate.end };
+    bool hasBefore = commonSegment.start > candidate.start;
+    bool hasAfter = commonSegment.end < candidate.end;
+
+    if (hasBefore && hasAfter)
     {
-      segments.insert(newSegment);
+      segments[removalCandidate] = before;
+      segments.Insert(removalCandidate + 1, after);
+      removalCandidate += 2;
+    }
+    else if (hasBefore || hasAfter)
+    {
+      segments[removalCandidate] = hasBefore ? before : after;
+      ++removalCandidate;
+    }
+    else
+    {
+      segments.Erase(removalCandidate, removalCandidate + 1);
     }
   }
 }
@@ -115,7 +151,7 @@ SegmentHolder SegmentHolder::operator&(const SegmentHolder& other) const
     return newHolder;
   }
 
-  const_iterator otherSegment = other.segments.lower_bound({ selfSegment->start,  selfSegment->start });
+  const_iterator otherSegment = other.begin() + other.LowerBound({ selfSegment->start,  selfSegment->start });
 
   while (otherSegment != other.end() && selfSegment != end())
   {
@@ -151,22 +187,24 @@ SegmentHolder::SegmentHolder()
 }
 
 SegmentHolder::SegmentHolder(Segment startSegment)
-  : segments({ startSegment })
+  : segments()
 {
-
+  segments.PushBack(startSegment);
 }
 
 void SegmentHolder::operator-=(Time deltaTime)
 {
-  std::set<Segment> newSegments;
-
-  for (const_iterator iterator = begin(); iterator != end(); ++iterator)
+  // Shifting keeps the order, so segments are changed in place
+  for (Segment& segment : segments)
   {
-    Segment newSegment = *iterator;
-    newSegment.end -= deltaTime;
-    newSegment.start -= deltaTime;
-    newSegments.insert(newSegment);
+    segment.end -= deltaTime;
+    segment.start -= deltaTime;
   }
+}
 
-  segments = newSegments;
+void SegmentHolder::MoveWindow(Time deltaTime, Time depth)
+{
+  operator-=(deltaTime);
+  RemoveSegment({ -deltaTime, 0 });
+  AddSegment({ std::max(0.f, depth - deltaTime), depth });
 }
@@ -1,4 +1,5 @@
 #include "shapes.h"
+#include <cassert>
 
 ArrayType<Point> Shape::ApplyShapeTo(Point point) const
 {
@@ -11,46 +12,139 @@ ArrayType<Point> Shape::ApplyShapeTo(Point point) const
   return result;
 }
 
-ShapeSpace::ShapeSpace(Time depth, std::shared_ptr<SegmentSpace> inSpace, const Shape& inShape)
+ShapeSpace::ShapeSpace(Time depth, std::shared_ptr<SegmentSpace> inSpace, const Shape& inShape,
+  std::shared_ptr<const RawSpace> inFootprintMap)
   : SpaceTime(depth)
   , originalSpace(inSpace)
   , shape(inShape)
-{ }
+  , footprintMap(inFootprintMap)
+  , isUpdated((size_t) inSpace->GetWidth() * inSpace->GetHeight(), false)
+{
+  // Footprints are only valid where the original space is defined, so they share its grid
+  segmentGrid = SegmentGrid(originalSpace->GetWidth(), originalSpace->GetHeight());
+  originalSpace->AddListener(this);
+}
 
-void ShapeSpace::UpdateShape(Point point)
+ShapeSpace::ShapeSpace(Time depth, std::shared_ptr<const SegmentSnapshot> inSnapshot, const Shape& inShape,
+  std::shared_ptr<const RawSpace> inFootprintMap)
+  : SpaceTime(depth)
+  , snapshot(inSnapshot)
+  , shape(inShape)
+  , footprintMap(inFootprintMap)
+  , isUpdated((size_t) inSnapshot->GetWidth() * inSnapshot->GetHeight(), false)
+{
+  segmentGrid = SegmentGrid(snapshot->GetWidth(), snapshot->GetHeight());
+}
+
+ShapeSpace::~ShapeSpace()
 {
-  if (pointCache.count(point))
+  if (originalSpace)
   {
-    return;
+    originalSpace->RemoveListener(this);
   }
+}
 
-  pointCache.insert(point);
+void ShapeSpace::OnSegmentsChanged(Point point)
+{
+  uint32_t width = segmentGrid.GetWidth();
+  uint32_t height = segmentGrid.GetHeight();
 
-  ArrayType<Point> joinedPoints = shape.ApplyShapeTo(point);
+  for (const Point& deltaPoint : shape.shape)
+  {
+    Point shapeOrigin = { point.x - deltaPoint.x, point.y - deltaPoint.y };
+    if (shapeOrigin.x >= 0 && (uint32_t) shapeOrigin.x < width && shapeOrigin.y >= 0 && (uint32_t) shapeOrigin.y < height)
+    {
+      isUpdated[shapeOrigin.x + (size_t) shapeOrigin.y * width] = false;
+    }
+    else
+    {
+      pointCache.erase(shapeOrigin);
+    }
+  }
+}
 
-  bool contains = true;
-  for (Point& originalSpacePoint : joinedPoints)
+void ShapeSpace::OnTimeMoved(Time deltaTime)
+{
+  // Moving the window of every original holder moves the window of their intersection
+  MoveTime(deltaTime);
+}
+
+void ShapeSpace::SetSnapshot(std::shared_ptr<const SegmentSnapshot> inSnapshot)
+{
+  assert(snapshot && inSnapshot->GetWidth() == snapshot->GetWidth() && inSnapshot->GetHeight() == snapshot->GetHeight());
+
+  std::shared_ptr<const SegmentSnapshot> previous = snapshot;
+  snapshot = inSnapshot;
+
+  for (size_t tileIndex = 0; tileIndex < snapshot->GetTiles().size(); ++tileIndex)
   {
-    if (!originalSpace->ContainsSegmentsIn(originalSpacePoint))
+    if (snapshot->IsTileShared(*previous, tileIndex)) continue;
+
+    const SegmentSnapshot::Tile& tile = *snapshot->GetTiles()[tileIndex];
+    const SegmentSnapshot::Tile& previousTile = *previous->GetTiles()[tileIndex];
+    int tileX = (int) (tileIndex % snapshot->GetTilesPerRow()) * SEGMENT_TILE_SIZE;
+    int tileY = (int) (tileIndex / snapshot->GetTilesPerRow()) * SEGMENT_TILE_SIZE;
+
+    for (size_t index = 0; index < tile.holders.size(); ++index)
     {
-      contains = false;
-      break;
+      if (tile.isPresent[index] == previousTile.isPresent[index] && tile.holders[index] == previousTile.holders[index]) continue;
+
+      OnSegmentsChanged({ tileX + (int) (index % SEGMENT_TILE_SIZE), tileY + (int) (index / SEGMENT_TILE_SIZE) });
     }
   }
+}
 
-  if (!contains)
+void ShapeSpace::UpdateShape(Point point)
+{
+  uint32_t width = segmentGrid.GetWidth();
+  uint32_t height = segmentGrid.GetHeight();
+
+  if (point.x >= 0 && (uint32_t) point.x < width && point.y >= 0 && (uint32_t) point.y < height)
+  {
+    size_t index = point.x + (size_t) point.y * width;
+    if (isUpdated[index]) return;
+    isUpdated[index] = true;
+  }
+  else if (!pointCache.insert(point).second)
   {
     return;
   }
 
-  segmentGrid[point] = SegmentHolder(Segment{ 0, depth });
-  for (Point& originalSpacePoint : joinedPoints)
+  // Static obstacles under the shape are resolved without touching the segments
+  if (footprintMap && (!footprintMap->Contains(point) || footprintMap->GetAccess(point) != Access::Accessable))
+  {
+    return;
+  }
+
+  for (const Point& deltaPoint : shape.shape)
+  {
+    if (!FindOriginalSegments(point + deltaPoint))
+    {
+      return;
+    }
+  }
+
+  SegmentHolder& footprint = segmentGrid[point];
+  footprint = SegmentHolder(Segment{ 0, depth });
+  for (const Point& deltaPoint : shape.shape)
   {
-    const SegmentHolder& segments = originalSpace->GetSegments(originalSpacePoint);
-    segmentGrid[point] = segmentGrid[point] & segments;
+    footprint = footprint & *FindOriginalSegments(point + deltaPoint);
   }
 }
 
+RawSpace ErodeByShape(const RawSpace& space, const Shape& shape)
+{
+  RawSpace eroded(space.GetWidth(), space.GetHeight());
+  eroded.Fill(Access::Accessable);
+
+  for (const Point& deltaPoint : shape.shape)
+  {
+    eroded.IntersectWithShifted(space, deltaPoint);
+  }
+
+  return eroded;
+}
+
 void FromPathToFilledAreas(const ArrayType<Node<Area>>& path, const Shape& shape, ArrayType<Area>& areas)
 {
   areas.clear();
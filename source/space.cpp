@@ -1,31 +1,195 @@
 #include "space.h"
+#include "bits.h"
 #include <cassert>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
 #include <algorithm>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SPACE_READER_MMAP
+#endif
+
+const Point RawSpace::NeighborOffsets[8] =
+{
+  { -1, -1 }, { 0, -1 }, { 1, -1 },
+  { -1, 0 }, { 1, 0 },
+  { -1, 1 }, { 0, 1 }, { 1, 1 },
+};
 
 RawSpace::RawSpace(uint32_t inWidth, uint32_t inHeight)
   : width(inWidth)
   , height(inHeight)
-  , grid((size_t) inWidth * inHeight, Access::Inaccessable)
+  , wordsPerRow((inWidth + 63) / 64)
+  , words((size_t) ((inWidth + 63) / 64) * inHeight, 0)
 {
 }
 
-Access RawSpace::GetAccess(Point point) const
+size_t RawSpace::PointToWord(const Point& point) const
 {
-  return grid[PointToIndex(point)];
+  assert(Contains(point));
+  return (size_t) point.y * wordsPerRow + point.x / 64;
 }
 
-size_t RawSpace::PointToIndex(Point& point) const
+Access RawSpace::GetAccess(Point point) const
 {
-  size_t index = point.x + (size_t) point.y * width;
-  assert(index < grid.size());
-  return index;
+  return (words[PointToWord(point)] >> (point.x % 64)) & 1 ? Access::Accessable : Access::Inaccessable;
 }
 
 void RawSpace::SetAccess(Point point, Access newAccess)
 {
-  grid[PointToIndex(point)] = newAccess;
+  uint64_t bit = uint64_t(1) << (point.x % 64);
+  uint64_t& word = words[PointToWord(point)];
+  word = newAccess == Access::Accessable ? word | bit : word & ~bit;
+}
+
+void RawSpace::SetRow(uint32_t row, const Access* accesses)
+{
+  assert(row < height);
+  uint64_t* rowWords = words.data() + (size_t) row * wordsPerRow;
+
+  for (uint32_t wordIndex = 0; wordIndex < wordsPerRow; ++wordIndex)
+  {
+    uint32_t first = wordIndex * 64;
+    uint32_t count = std::min(width - first, 64u);
+
+    uint64_t word = 0;
+    for (uint32_t bit = 0; bit < count; ++bit)
+    {
+      word |= (uint64_t) (accesses[first + bit] == Access::Accessable) << bit;
+    }
+    rowWords[wordIndex] = word;
+  }
+}
+
+void RawSpace::Fill(Access access)
+{
+  for (uint32_t row = 0; row < height; ++row)
+  {
+    uint64_t* rowWords = words.data() + (size_t) row * wordsPerRow;
+    for (uint32_t wordIndex = 0; wordIndex < wordsPerRow; ++wordIndex)
+    {
+      // Padding bits stay zero
+      uint32_t count = std::min(width - wordIndex * 64, 64u);
+      rowWords[wordIndex] = access == Access::Accessable ? LowBitsMask(count) : 0;
+    }
+  }
+}
+
+void RawSpace::IntersectWithShifted(const RawSpace& source, Point offset)
+{
+  assert(source.width == width && source.height == height);
+
+  for (uint32_t row = 0; row < height; ++row)
+  {
+    uint64_t* rowWords = words.data() + (size_t) row * wordsPerRow;
+    for (uint32_t wordIndex = 0; wordIndex < wordsPerRow; ++wordIndex)
+    {
+      uint32_t count = std::min(width - wordIndex * 64, 64u);
+      rowWords[wordIndex] &= source.GetRowBits((int) row + offset.y, (int) (wordIndex * 64) + offset.x, count);
+    }
+  }
+}
+
+uint64_t RawSpace::GetRowBits(int row, int x, uint32_t count) const
+{
+  assert(count <= 64);
+  if (row < 0 || (uint32_t) row >= height) return 0;
+
+  int64_t from = std::max<int64_t>(x, 0);
+  int64_t to = std::min<int64_t>((int64_t) x + count, width);
+  if (from >= to) return 0;
+
+  const uint64_t* rowWords = words.data() + (size_t) row * wordsPerRow;
+  uint32_t wordIndex = (uint32_t) from / 64;
+  uint32_t bitIndex = (uint32_t) from % 64;
+
+  uint64_t bits = rowWords[wordIndex] >> bitIndex;
+  if (bitIndex != 0 && wordIndex + 1 < wordsPerRow)
+  {
+    bits |= rowWords[wordIndex + 1] << (64 - bitIndex);
+  }
+
+  bits &= LowBitsMask((uint32_t) (to - from));
+  return bits << (from - x);
+}
+
+bool RawSpace::AreAllAccessable(Point origin, const ArrayType<Point>& offsets) const
+{
+  for (const Point& offset : offsets)
+  {
+    Point point = origin + offset;
+    if (!Contains(point) || !((words[PointToWord(point)] >> (point.x % 64)) & 1))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool RawSpace::IsSpanAccessable(Point from, uint32_t length) const
+{
+  for (uint32_t offset = 0; offset < length; offset += 64)
+  {
+    uint32_t count = std::min(length - offset, 64u);
+    if (GetRowBits(from.y, from.x + (int) offset, count) != LowBitsMask(count))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint8_t RawSpace::GetAccessableNeighbors(Point point) const
+{
+  uint64_t above = GetRowBits(point.y - 1, point.x - 1, 3);
+  uint64_t middle = GetRowBits(point.y, point.x - 1, 3);
+  uint64_t below = GetRowBits(point.y + 1, point.x - 1, 3);
+
+  return (uint8_t) (above | (middle & 1) << 3 | (middle >> 2 & 1) << 4 | below << 5);
+}
+
+int RawSpace::FindInaccessableInRow(Point from, int direction) const
+{
+  assert(direction == 1 || direction == -1);
+  if (!Contains(from)) return from.x;
+
+  const uint64_t* rowWords = words.data() + (size_t) from.y * wordsPerRow;
+  uint32_t wordIndex = from.x / 64;
+  uint32_t bitIndex = from.x % 64;
+
+  // Padding bits are zero, so they stop the scan like the grid border
+  if (direction > 0)
+  {
+    uint64_t blocked = ~rowWords[wordIndex] & (~uint64_t(0) << bitIndex);
+    while (!blocked)
+    {
+      if (++wordIndex == wordsPerRow) return (int) width;
+      blocked = ~rowWords[wordIndex];
+    }
+
+    return (int) std::min(wordIndex * 64 + CountTrailingZeros(blocked), width);
+  }
+
+  uint64_t blocked = ~rowWords[wordIndex] & LowBitsMask(bitIndex + 1);
+  while (!blocked)
+  {
+    if (wordIndex-- == 0) return -1;
+    blocked = ~rowWords[wordIndex];
+  }
+
+  return (int) (wordIndex * 64 + FindHighestBit(blocked));
 }
 
 uint32_t RawSpace::GetWidth() const
@@ -43,101 +207,269 @@ bool RawSpace::Contains(Point point) const
   return point.x >= 0 && (uint32_t) point.x < width && point.y >= 0 && (uint32_t) point.y < height;
 }
 
+namespace
+{
+  inline bool IsBlank(char symbol)
+  {
+    return symbol == ' ' || symbol == '\t' || symbol == '\r' || symbol == '\n';
+  }
+
+  std::string_view ReadToken(const char*& data, const char* dataEnd)
+  {
+    while (data != dataEnd && IsBlank(*data)) ++data;
+
+    const char* tokenStart = data;
+    while (data != dataEnd && !IsBlank(*data)) ++data;
+
+    return std::string_view(tokenStart, data - tokenStart);
+  }
+
+  bool ReadNumber(const char*& data, const char* dataEnd, uint32_t& number)
+  {
+    std::string_view token = ReadToken(data, dataEnd);
+    const char* tokenEnd = token.data() + token.size();
+    std::from_chars_result result = std::from_chars(token.data(), tokenEnd, number);
+    return result.ec == std::errc() && result.ptr == tokenEnd;
+  }
+
+  void SkipLine(const char*& data, const char* dataEnd)
+  {
+    const void* lineEnd = std::memchr(data, '\n', dataEnd - data);
+    data = lineEnd ? (const char*) lineEnd + 1 : dataEnd;
+  }
+}
+
 SpaceReader::SpaceReader()
-  : symbolToAccess({ 
-    {'@', Access::Inaccessable}, 
-    {'.', Access::Accessable} })
 {
+  // MovingAI terrain: '.' and 'G' are ground, 'S' is swamp which is passable.
+  // '@' and 'O' are out of bounds, 'T' are trees and 'W' is water, agents can't enter them.
+  symbolToAccess.fill(Access::Inaccessable);
+  for (char symbol : { '.', 'G', 'S' })
+  {
+    symbolToAccess[(uint8_t) symbol] = Access::Accessable;
+  }
 }
 
-std::optional<RawSpace> SpaceReader::FromHogFormat(std::istream& file)
+std::optional<RawSpace> SpaceReader::FromHogFormat(std::istream& file) const
 {
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  return FromHogFormat(content.data(), content.size());
+}
+
+std::optional<RawSpace> SpaceReader::FromHogFormat(const char* data, size_t size) const
+{
+  const char* dataEnd = data + size;
   uint32_t width = 0, height = 0;
 
-  if (!CheckHogFileStart(file, width, height)) return {};
-  file.ignore(2, '\n');
+  if (!ReadHogHeader(data, dataEnd, width, height)) return {};
+  SkipLine(data, dataEnd);
 
   RawSpace readSpace(width, height);
+  ArrayType<Access> rowAccess(width);
 
-  char grid_value;
-  for (int row = 0; row < (int) height; ++row)
+  for (uint32_t row = 0; row < height; ++row)
   {
-    for (int column = 0; column < (int) width; ++column)
+    const void* lineEnd = std::memchr(data, '\n', dataEnd - data);
+    size_t lineLength = (lineEnd ? (const char*) lineEnd : dataEnd) - data;
+    if (lineLength < width)
     {
-      file.get(grid_value);
-      Access newAccess = Access::Inaccessable;
-      if (symbolToAccess.count(grid_value))
-      {
-        newAccess = symbolToAccess[grid_value];
-      }
+      std::cerr << "SpaceReader::FromHogFormat: row " << row << " is shorter than the map width\n";
+      return {};
+    }
 
-      readSpace.SetAccess(Point{ column, row }, newAccess);
+    for (uint32_t column = 0; column < width; ++column)
+    {
+      rowAccess[column] = symbolToAccess[(uint8_t) data[column]];
     }
+    readSpace.SetRow(row, rowAccess.data());
 
-    file.ignore(2, '\n');
+    data = lineEnd ? (const char*) lineEnd + 1 : dataEnd;
   }
 
   return std::move(readSpace);
 }
 
-bool SpaceReader::CheckHogFileStart(std::istream& file, uint32_t& width, uint32_t& height)
+std::optional<RawSpace> SpaceReader::FromHogFile(const char* fileName) const
 {
-  std::string buffer;
-  std::string type;
+#ifdef SPACE_READER_MMAP
+  int descriptor = open(fileName, O_RDONLY);
+  if (descriptor < 0)
+  {
+    std::cerr << "SpaceReader::FromHogFile: cannot open " << fileName << "\n";
+    return {};
+  }
 
-  file >> buffer;
-  if (buffer != "type")
+  struct stat fileStat;
+  if (fstat(descriptor, &fileStat) != 0 || fileStat.st_size == 0)
   {
-    std::cerr << "ReadSpace::FromHogFormat: cannot find \"type\" in file\n";
-    return false;
+    close(descriptor);
+    std::cerr << "SpaceReader::FromHogFile: " << fileName << " is empty\n";
+    return {};
   }
 
-  file >> buffer;
-  if (buffer != "octile")
+  size_t size = (size_t) fileStat.st_size;
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (mapped == MAP_FAILED)
   {
-    std::cerr << "ReadSpace::FromHogFormat: type is not \"octile\"\n";
+    std::cerr << "SpaceReader::FromHogFile: cannot map " << fileName << "\n";
+    return {};
+  }
+
+  madvise(mapped, size, MADV_SEQUENTIAL);
+  std::optional<RawSpace> readSpace = FromHogFormat((const char*) mapped, size);
+  munmap(mapped, size);
+
+  return readSpace;
+#else
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file.is_open())
+  {
+    std::cerr << "SpaceReader::FromHogFile: cannot open " << fileName << "\n";
+    return {};
+  }
+
+  return FromHogFormat(file);
+#endif
+}
+
+bool SpaceReader::ReadHogHeader(const char*& data, const char* dataEnd, uint32_t& width, uint32_t& height) const
+{
+  if (ReadToken(data, dataEnd) != "type")
+  {
+    std::cerr << "SpaceReader::FromHogFormat: cannot find \"type\" in file\n";
     return false;
   }
 
-  file >> buffer >> height >> buffer >> width >> buffer;
-  if (buffer != "map")
+  if (ReadToken(data, dataEnd) != "octile")
   {
-    std::cerr << "ReadSpace::FromHogFormat: cannot find \"map\" in file\n";
+    std::cerr << "SpaceReader::FromHogFormat: type is not \"octile\"\n";
     return false;
   }
 
-  if (file.fail())
+  bool isHeightFound = false, isWidthFound = false;
+  for (std::string_view key = ReadToken(data, dataEnd); key != "map"; key = ReadToken(data, dataEnd))
+  {
+    if (key == "height")
+    {
+      isHeightFound = ReadNumber(data, dataEnd, height);
+    }
+    else if (key == "width")
+    {
+      isWidthFound = ReadNumber(data, dataEnd, width);
+    }
+    else
+    {
+      std::cerr << "SpaceReader::FromHogFormat: cannot find \"map\" in file\n";
+      return false;
+    }
+  }
+
+  if (!isHeightFound || !isWidthFound)
   {
-    std::cerr << "ReadSpace::FromHogFormat: file read failed\n";
+    std::cerr << "SpaceReader::FromHogFormat: map size is not found\n";
     return false;
   }
 
   return true;
 }
 
+SegmentGrid::SegmentGrid()
+  : width(0)
+  , height(0)
+  , timeOffset(0)
+  , depth(0)
+{ }
+
+SegmentGrid::SegmentGrid(uint32_t inWidth, uint32_t inHeight)
+  : holders((size_t) inWidth * inHeight)
+  , isPresent((size_t) inWidth * inHeight, false)
+  , width(inWidth)
+  , height(inHeight)
+  , timeOffset(0)
+  , depth(0)
+{ }
+
+const SegmentHolder* SegmentGrid::Find(Point point) const
+{
+  if (IsInside(point))
+  {
+    size_t index = PointToIndex(point);
+    return isPresent[index] ? &Synchronise(holders[index]) : nullptr;
+  }
+
+  auto found = outerHolders.find(point);
+  return found == outerHolders.end() ? nullptr : &Synchronise(found->second);
+}
+
+SegmentHolder* SegmentGrid::Find(Point point)
+{
+  return const_cast<SegmentHolder*>(std::as_const(*this).Find(point));
+}
+
+SegmentHolder& SegmentGrid::operator[](Point point)
+{
+  if (IsInside(point))
+  {
+    size_t index = PointToIndex(point);
+    if (!isPresent[index])
+    {
+      isPresent[index] = true;
+      holders[index] = { SegmentHolder(), timeOffset };
+    }
+
+    return Synchronise(holders[index]);
+  }
+
+  auto [holder, isInserted] = outerHolders.try_emplace(point, TimedHolder{ SegmentHolder(), timeOffset });
+  return Synchronise(holder->second);
+}
+
+void SegmentGrid::MoveTime(Time deltaTime, Time inDepth)
+{
+  assert(deltaTime >= 0);
+  assert(depth == 0 || depth == inDepth);
+
+  depth = inDepth;
+  timeOffset += deltaTime;
+}
+
 const SegmentHolder& SegmentSpace::GetSegments(Point point) const
 {
-  assert(ContainsSegmentsIn(point));
-  return segmentGrid.at(point);
+  const SegmentHolder* segments = segmentGrid.Find(point);
+  assert(segments);
+  return *segments;
 }
 
 void SegmentSpace::SetSegments(Point point, const SegmentHolder & newAccess)
 { 
   segmentGrid[point] = newAccess;
+  NotifyChanged(point);
 }
 
 bool SegmentSpace::ContainsSegmentsIn(Point point) const
 {
-  return segmentGrid.count(point) > 0;
+  return segmentGrid.Find(point) != nullptr;
+}
+
+uint32_t SegmentSpace::GetWidth() const
+{
+  return segmentGrid.GetWidth();
+}
+
+uint32_t SegmentSpace::GetHeight() const
+{
+  return segmentGrid.GetHeight();
 }
 
 SegmentSpace::SegmentSpace(Time depth, const RawSpace& base)
+  : segmentGrid(base.GetWidth(), base.GetHeight())
 {
   assert(depth > 0);
 
-  for (int x = 0; x < (int) base.GetWidth(); ++x)
+  for (int y = 0; y < (int) base.GetHeight(); ++y)
   {
-    for (int y = 0; y < (int) base.GetHeight(); ++y)
+    for (int x = 0; x < (int) base.GetWidth(); ++x)
     {
       Point point = { x, y };
 
@@ -153,12 +485,14 @@ void SegmentSpace::MakeAreasInaccessable(const std::vector<Area>& areas)
 {
   for (const Area& area : areas)
   {
-    if (!ContainsSegmentsIn(area.point))
+    SegmentHolder* segments = segmentGrid.Find(area.point);
+    if (!segments)
     {
       continue;
     }
 
-    segmentGrid[area.point].RemoveSegment(area.interval);
+    segments->RemoveSegment(area.interval);
+    NotifyChanged(area.point);
 
     // If segment holder becomes empty, it is still contained inside the SegmentSpace,
     // because in future it may be needed to add accessable intervals there
@@ -169,31 +503,30 @@ Access SegmentSpace::GetAccess(Area cell) const
 {
   assert(Contains(cell));
 
-  return segmentGrid.at(cell.point).Contains(cell.interval) ? Access::Accessable : Access::Inaccessable;
+  return segmentGrid.Find(cell.point)->Contains(cell.interval) ? Access::Accessable : Access::Inaccessable;
 }
 
 void SegmentSpace::SetAccess(Area cell, Access Access)
 {
-  assert(segmentGrid.count(cell.point) > 0);
+  SegmentHolder* segments = segmentGrid.Find(cell.point);
+  assert(segments);
 
   if (Access == Access::Accessable)
   {
-    segmentGrid.at(cell.point).AddSegment(cell.interval);
+    segments->AddSegment(cell.interval);
   }
   else if (Access == Access::Inaccessable)
   {
-    segmentGrid.at(cell.point).RemoveSegment(cell.interval);
+    segments->RemoveSegment(cell.interval);
   }
+
+  NotifyChanged(cell.point);
 }
 
 bool SegmentSpace::Contains(Area cell) const
 {
-  if (segmentGrid.count(cell.point) == 0)
-  {
-    return false;
-  }
-
-  return segmentGrid.at(cell.point).Contains(cell.interval);
+  const SegmentHolder* segments = segmentGrid.Find(cell.point);
+  return segments && segments->Contains(cell.interval);
 }
 
 SpaceTime::SpaceTime(Time inDepth, const RawSpace& base)
@@ -212,11 +545,12 @@ void SpaceTime::MoveTime(Time deltaTime)
 {
   assert(deltaTime >= 0);
 
-  for (auto& [point, segment] : segmentGrid)
+  // Cells are shifted lazily when they are accessed
+  segmentGrid.MoveTime(deltaTime, depth);
+
+  for (SegmentSpaceListener* listener : listeners)
   {
-    segment -= deltaTime;
-    segment.RemoveSegment( {-deltaTime, 0} );
-    segment.AddSegment({std::max(0.f, depth - deltaTime), depth});
+    listener->OnTimeMoved(deltaTime);
   }
 }
 
@@ -224,6 +558,131 @@ SegmentSpace::SegmentSpace()
   : segmentGrid()
 { }
 
+SegmentSpace::SegmentSpace(const SegmentSpace& other)
+  : segmentGrid(other.segmentGrid)
+{ }
+
+SegmentSpace& SegmentSpace::operator=(const SegmentSpace& other)
+{
+  segmentGrid = other.segmentGrid;
+  return *this;
+}
+
+void SegmentSpace::AddListener(SegmentSpaceListener* listener)
+{
+  listeners.push_back(listener);
+}
+
+void SegmentSpace::RemoveListener(SegmentSpaceListener* listener)
+{
+  listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
 SpaceTime::SpaceTime(Time inDepth)
   : depth(inDepth)
 { }
+
+SegmentSnapshot::SegmentSnapshot(uint64_t inVersion, uint32_t inWidth, uint32_t inHeight,
+  ArrayType<std::shared_ptr<const Tile>> inTiles)
+  : version(inVersion)
+  , width(inWidth)
+  , height(inHeight)
+  , tilesPerRow((inWidth + SEGMENT_TILE_SIZE - 1) / SEGMENT_TILE_SIZE)
+  , tiles(std::move(inTiles))
+{ }
+
+const SegmentHolder& SegmentSnapshot::GetSegments(Point point) const
+{
+  const SegmentHolder* segments = Find(point);
+  assert(segments);
+  return *segments;
+}
+
+bool SegmentSnapshot::IsTileShared(const SegmentSnapshot& other, size_t tileIndex) const
+{
+  assert(width == other.width && height == other.height);
+  return tiles[tileIndex] == other.tiles[tileIndex];
+}
+
+SegmentSpacePublisher::SegmentSpacePublisher(std::shared_ptr<SegmentSpace> inSpace)
+  : space(inSpace)
+  , tilesPerRow((inSpace->GetWidth() + SEGMENT_TILE_SIZE - 1) / SEGMENT_TILE_SIZE)
+{
+  uint32_t tilesPerColumn = (space->GetHeight() + SEGMENT_TILE_SIZE - 1) / SEGMENT_TILE_SIZE;
+  isTileChanged.assign((size_t) tilesPerRow * tilesPerColumn, true);
+
+  space->AddListener(this);
+  Publish();
+}
+
+SegmentSpacePublisher::~SegmentSpacePublisher()
+{
+  space->RemoveListener(this);
+}
+
+void SegmentSpacePublisher::OnSegmentsChanged(Point point)
+{
+  if (point.x < 0 || (uint32_t) point.x >= space->GetWidth() || point.y < 0 || (uint32_t) point.y >= space->GetHeight())
+  {
+    return;
+  }
+
+  isTileChanged[SegmentSnapshot::GetTileIndex(point, tilesPerRow)] = true;
+  isChanged = true;
+}
+
+void SegmentSpacePublisher::OnTimeMoved(Time)
+{
+  std::fill(isTileChanged.begin(), isTileChanged.end(), true);
+  isChanged = true;
+}
+
+std::shared_ptr<const SegmentSnapshot> SegmentSpacePublisher::Publish()
+{
+  if (!isChanged)
+  {
+    return latest;
+  }
+
+  ArrayType<std::shared_ptr<const SegmentSnapshot::Tile>> tiles(isTileChanged.size());
+  uint64_t version = 0;
+  if (latest)
+  {
+    tiles = latest->GetTiles();
+    version = latest->GetVersion() + 1;
+  }
+
+  for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+  {
+    if (!isTileChanged[tileIndex]) continue;
+
+    // Holders are copied from the space, so its lazy synchronisation never reaches readers
+    std::shared_ptr<SegmentSnapshot::Tile> tile = std::make_shared<SegmentSnapshot::Tile>();
+    int tileX = (int) (tileIndex % tilesPerRow) * SEGMENT_TILE_SIZE;
+    int tileY = (int) (tileIndex / tilesPerRow) * SEGMENT_TILE_SIZE;
+    for (int y = tileY; y < tileY + SEGMENT_TILE_SIZE && (uint32_t) y < space->GetHeight(); ++y)
+    {
+      for (int x = tileX; x < tileX + SEGMENT_TILE_SIZE && (uint32_t) x < space->GetWidth(); ++x)
+      {
+        Point point = { x, y };
+        if (!space->ContainsSegmentsIn(point)) continue;
+
+        size_t index = SegmentSnapshot::GetIndexInTile(point);
+        tile->holders[index] = space->GetSegments(point);
+        tile->isPresent[index] = true;
+      }
+    }
+
+    tiles[tileIndex] = tile;
+    isTileChanged[tileIndex] = false;
+  }
+
+  std::atomic_store(&latest, std::make_shared<const SegmentSnapshot>(version, space->GetWidth(), space->GetHeight(), std::move(tiles)));
+  isChanged = false;
+  return latest;
+}
+
+std::shared_ptr<const SegmentSnapshot> SegmentSpacePublisher::GetSnapshot() const
+{
+  return std::atomic_load(&latest);
+}
@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+#include <cassert>
+
+ThreadPool::ThreadPool(unsigned threadsCount)
+  : nextIndex(0)
+{
+  for (unsigned i = 1; i < threadsCount; ++i)
+  {
+    workers.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+
+  taskReady.notify_all();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::GetThreadsCount() const
+{
+  return workers.size() + 1;
+}
+
+void ThreadPool::RunIndices()
+{
+  for (size_t index = nextIndex++; index < taskSize; index = nextIndex++)
+  {
+    task(index);
+  }
+}
+
+void ThreadPool::WorkerLoop()
+{
+  uint64_t finishedGeneration = 0;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      taskReady.wait(lock, [this, finishedGeneration] { return isStopping || taskGeneration != finishedGeneration; });
+      if (isStopping)
+      {
+        return;
+      }
+
+      finishedGeneration = taskGeneration;
+    }
+
+    RunIndices();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--activeWorkers == 0)
+      {
+        taskDone.notify_one();
+      }
+    }
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(activeWorkers == 0);
+
+    task = function;
+    taskSize = count;
+    nextIndex = 0;
+    activeWorkers = workers.size();
+    ++taskGeneration;
+  }
+
+  taskReady.notify_all();
+  RunIndices();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  taskDone.wait(lock, [this] { return activeWorkers == 0; });
+  task = nullptr;
+}
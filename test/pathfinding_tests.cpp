@@ -1,5 +1,15 @@
 #include "pathfinder.h"
+#include "bidirectional_pathfinder.h"
+#include "cluster_graph.h"
+#include "heuristic_cache.h"
+#include "move_sets.h"
+#include "jump_point_moves.h"
+#include "rolling_horizon.h"
+#include "speculative_planner.h"
+#include <random>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
 
 class MovesTest : public MoveComponent<Point>
 {
@@ -110,6 +120,1146 @@ TEST(PathfindingTests, SimpleMap)
   ASSERT_EQ(cost, 2);
 }
 
+template<typename OpenListType>
+void CheckOpenListOnSimpleMap()
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(3, 3));
+  space->SetAccess({ 0, 0 }, Access::Accessable);
+  space->SetAccess({ 0, 1 }, Access::Accessable);
+  space->SetAccess({ 0, 2 }, Access::Accessable);
+  space->SetAccess({ 1, 2 }, Access::Accessable);
+
+  Point origin = { 0, 0 };
+  Point destination = { 1, 2 };
+
+  ArrayType<Move<Point>> moves =
+  {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+  };
+
+  std::shared_ptr<EuclideanHeuristic> h(new EuclideanHeuristic(destination));
+  std::shared_ptr<MovesTest> movesComponent(new MovesTest(moves, space.get()));
+
+  Pathfinder<Point, OpenListType> simplePathfinding(movesComponent, origin, h);
+  simplePathfinding.SetGridBounds(space->GetWidth(), space->GetHeight());
+
+  simplePathfinding.FindCost(destination);
+  ASSERT_TRUE(simplePathfinding.IsCostFound(destination));
+  ASSERT_EQ(simplePathfinding.GetCost(destination), 3);
+
+  ArrayType<Node<Point>> path;
+  simplePathfinding.CollectPath(destination, path);
+  ASSERT_EQ(path.size(), 4);
+  ASSERT_EQ(path[0].cell, origin);
+  ASSERT_EQ(path[3].cell, destination);
+}
+
+TEST(PathfindingTests, SimpleMapOpenLists)
+{
+  CheckOpenListOnSimpleMap<NodesBinaryHeap<Point>>();
+  CheckOpenListOnSimpleMap<NodesDaryHeap<Point, 4>>();
+  CheckOpenListOnSimpleMap<NodesBucketQueue<Point>>();
+}
+
+TEST(PathfindingTests, ResetReusesPathfinder)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(4, 4));
+  for (int x = 0; x < 4; ++x)
+  {
+    for (int y = 0; y < 4; ++y)
+    {
+      if (x != 1 || y == 3) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  ArrayType<Move<Point>> moves =
+  {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+  };
+  std::shared_ptr<MovesTest> movesComponent(new MovesTest(moves, space.get()));
+
+  Pathfinder<Point> reused(movesComponent, { 0, 0 }, std::make_shared<EuclideanHeuristic>(Point{ 3, 0 }));
+  reused.SetGridBounds(space->GetWidth(), space->GetHeight());
+  reused.FindCost({ 3, 0 });
+  ASSERT_TRUE(reused.IsCostFound({ 3, 0 }));
+  ASSERT_EQ(reused.GetCost({ 3, 0 }), 9);
+
+  for (Point origin : { Point{ 2, 0 }, Point{ 0, 3 }, Point{ 0, 0 } })
+  {
+    Point destination = { 3, 0 };
+    reused.Reset(origin, std::make_shared<EuclideanHeuristic>(destination));
+    ASSERT_FALSE(reused.IsCostFound(destination));
+    reused.FindCost(destination);
+
+    Pathfinder<Point> fresh(movesComponent, origin, std::make_shared<EuclideanHeuristic>(destination));
+    fresh.FindCost(destination);
+
+    ASSERT_TRUE(reused.IsCostFound(destination));
+    ASSERT_EQ(reused.GetCost(destination), fresh.GetCost(destination));
+
+    ArrayType<Node<Point>> path;
+    reused.CollectPath(destination, path);
+    ASSERT_EQ(path.front().cell, origin);
+    ASSERT_EQ(path.back().cell, destination);
+  }
+}
+
+TEST(PathfindingTests, SearchStatistics)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(4, 4));
+  for (int x = 0; x < 4; ++x)
+  {
+    for (int y = 0; y < 4; ++y)
+    {
+      if (x != 1 || y == 3) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  ArrayType<Move<Point>> moves =
+  {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+  };
+  std::shared_ptr<MovesTest> movesComponent(new MovesTest(moves, space.get()));
+
+  Pathfinder<Point> pathfinder(movesComponent, { 0, 0 }, std::make_shared<EuclideanHeuristic>(Point{ 3, 0 }));
+  pathfinder.FindCost({ 3, 0 });
+  ASSERT_TRUE(pathfinder.IsCostFound({ 3, 0 }));
+
+  ArrayType<Node<Point>> path;
+  pathfinder.CollectPath({ 3, 0 }, path);
+
+  const SearchResult<Point>& stats = pathfinder.GetStats();
+  ASSERT_GT(stats.GetStepsCount(), 0);
+  ASSERT_EQ(stats.GetGeneratedCount(), stats.GetNodesCount());
+  ASSERT_EQ(stats.GetHeapPushesCount(), stats.GetGeneratedCount());
+  ASSERT_EQ(stats.GetHeapPopsCount(), stats.GetStepsCount());
+  ASSERT_GT(stats.GetDuplicatesCount(), 0);
+  ASSERT_GT(stats.GetPeakOpenSize(), 0);
+  ASSERT_GE(stats.GetTime(), stats.GetMovesTime());
+
+  std::stringstream header;
+  SearchResult<Point>::WriteCsvHeader(header);
+  std::stringstream row;
+  stats.WriteCsvRow(row);
+  std::string headerLine = header.str();
+  std::string rowLine = row.str();
+  ASSERT_EQ(std::count(headerLine.begin(), headerLine.end(), ','), std::count(rowLine.begin(), rowLine.end(), ','));
+
+  std::stringstream json;
+  stats.WriteJson(json);
+  ASSERT_NE(json.str().find("\"expansions\": " + std::to_string(stats.GetStepsCount())), std::string::npos);
+
+  pathfinder.Reset({ 0, 0 });
+  ASSERT_EQ(pathfinder.GetStats().GetStepsCount(), 0);
+  ASSERT_EQ(pathfinder.GetStats().GetGeneratedCount(), 1);
+}
+
+TEST(PathfindingTests, AppendValidMoves)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(3, 3));
+  space->SetAccess({ 1, 1 }, Access::Accessable);
+  space->SetAccess({ 1, 2 }, Access::Accessable);
+  space->SetAccess({ 2, 1 }, Access::Accessable);
+
+  ArrayType<Move<Point>> moves =
+  {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+  };
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  GridMoves gridMoves(space, pointShape, moves);
+  MovesTest adaptedMoves(moves, space.get());
+
+  // Moves are appended after the existing ones, the buffer keeps its capacity
+  ArrayType<Move<Point>> buffer = { Move<Point>{ 5, {0, 0}} };
+  gridMoves.AppendValidMoves(Node<Point>({ 1, 1 }), buffer);
+  ASSERT_EQ(buffer.size(), 3);
+  ASSERT_EQ(buffer[1].destination, Point(1, 2));
+  ASSERT_EQ(buffer[2].destination, Point(2, 1));
+
+  buffer.clear();
+  adaptedMoves.AppendValidMoves(Node<Point>({ 1, 1 }), buffer);
+  ArrayType<Move<Point>> found = adaptedMoves.FindValidMoves(Node<Point>({ 1, 1 }));
+  ASSERT_EQ(buffer.size(), found.size());
+  for (size_t i = 0; i < found.size(); ++i)
+  {
+    ASSERT_EQ(buffer[i].destination, found[i].destination);
+  }
+}
+
+TEST(PathfindingTests, StaticMoveSets)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(6, 5));
+  for (int x = 0; x < 6; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      if ((x * 5 + y * 3) % 7 != 0) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  Shape wideShape = { ArrayType<Point>{ {0, 0}, {1, 0} } };
+  GridMoves fourMoves(space, pointShape, MakeMoves<FourConnectedMoves>());
+  GridMoves eightMoves(space, pointShape, MakeMoves<EightConnectedMoves>());
+  GridMoves wideMoves(space, wideShape, MakeMoves<EightConnectedMoves>());
+
+  StaticGridMoves<FourConnectedMoves> staticFour(space);
+  StaticGridMoves<EightConnectedMoves> staticEight(space);
+  StaticGridMoves<EightConnectedMoves> staticWide(*space, wideShape);
+  StaticGridMoves<EightConnectedNoCornerCuttingMoves> staticNoCutting(space);
+
+  auto checkSame = [](const ArrayType<Move<Point>>& expected, const ArrayType<Move<Point>>& actual)
+  {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      ASSERT_EQ(expected[i].destination, actual[i].destination);
+      ASSERT_EQ(expected[i].cost, actual[i].cost);
+    }
+  };
+
+  for (int x = 0; x < 6; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      Node<Point> node({ x, y });
+      checkSame(fourMoves.FindValidMoves(node), staticFour.FindValidMoves(node));
+      checkSame(eightMoves.FindValidMoves(node), staticEight.FindValidMoves(node));
+      checkSame(wideMoves.FindValidMoves(node), staticWide.FindValidMoves(node));
+
+      ArrayType<Move<Point>> noCutting;
+      for (const Move<Point>& move : eightMoves.FindValidMoves(node))
+      {
+        Point delta = { move.destination.x - x, move.destination.y - y };
+        bool isDiagonal = delta.x != 0 && delta.y != 0;
+        if (!isDiagonal || (eightMoves.IsValid({ x + delta.x, y }) && eightMoves.IsValid({ x, y + delta.y })))
+        {
+          noCutting.push_back(move);
+        }
+      }
+      checkSame(noCutting, staticNoCutting.FindValidMoves(node));
+    }
+  }
+}
+
+TEST(PathfindingTests, JumpPointSearch)
+{
+  std::mt19937 random(7);
+  int solvedCount = 0;
+  for (int mapIndex = 0; mapIndex < 20; ++mapIndex)
+  {
+    std::shared_ptr<RawSpace> space(new RawSpace(150, 17));
+    for (int x = 0; x < 150; ++x)
+    {
+      for (int y = 0; y < 17; ++y)
+      {
+        if (random() % 5) space->SetAccess({ x, y }, Access::Accessable);
+      }
+    }
+
+    Point origin = { 1, 1 };
+    // Rows are wider than a word, so horizontal jumps cross word borders
+    Point goal = { 148, 15 };
+    space->SetAccess(origin, Access::Accessable);
+    space->SetAccess(goal, Access::Accessable);
+
+    std::shared_ptr<StaticGridMoves<EightConnectedNoCornerCuttingMoves>> gridMoves =
+      std::make_shared<StaticGridMoves<EightConnectedNoCornerCuttingMoves>>(space);
+    std::shared_ptr<JumpPointMoves> jumpMoves = std::make_shared<JumpPointMoves>(space, goal);
+
+    Pathfinder<Point> search(gridMoves, origin, std::make_shared<EuclideanHeuristic>(goal));
+    Pathfinder<Point> jumpSearch(jumpMoves, origin, std::make_shared<EuclideanHeuristic>(goal));
+    search.SettleCost(goal);
+    jumpSearch.SettleCost(goal);
+
+    ASSERT_EQ(search.IsCostSettled(goal), jumpSearch.IsCostSettled(goal));
+    if (!search.IsCostSettled(goal)) continue;
+
+    solvedCount++;
+    ASSERT_NEAR(search.GetCost(goal), jumpSearch.GetCost(goal), 1e-4);
+    ASSERT_LE(jumpSearch.GetStats().GetNodesCount(), search.GetStats().GetNodesCount());
+
+    // Consecutive jump points are connected by straight or diagonal runs
+    ArrayType<Node<Point>> path;
+    jumpSearch.CollectPath(goal, path);
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+      int deltaX = std::abs(path[i + 1].cell.x - path[i].cell.x);
+      int deltaY = std::abs(path[i + 1].cell.y - path[i].cell.y);
+      ASSERT_TRUE(deltaX == 0 || deltaY == 0 || deltaX == deltaY);
+    }
+  }
+
+  ASSERT_GT(solvedCount, 10);
+}
+
+TEST(PathfindingTests, BoundedSuboptimalSearch)
+{
+  std::mt19937 random(11);
+  std::shared_ptr<RawSpace> space(new RawSpace(40, 40));
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 40; ++y)
+    {
+      if (random() % 5) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Point origin = { 0, 0 };
+  Point goal = { 39, 39 };
+  space->SetAccess(origin, Access::Accessable);
+  space->SetAccess(goal, Access::Accessable);
+  std::shared_ptr<StaticGridMoves<EightConnectedMoves>> moves = std::make_shared<StaticGridMoves<EightConnectedMoves>>(space);
+
+  Pathfinder<Point> optimal(moves, origin, std::make_shared<EuclideanHeuristic>(goal));
+  optimal.SettleCost(goal);
+  ASSERT_TRUE(optimal.IsCostSettled(goal));
+  Time optimalCost = optimal.GetCost(goal);
+
+  for (Time bound : { 1.f, 1.2f, 2.f })
+  {
+    Pathfinder<Point> weighted(moves, origin, std::make_shared<EuclideanHeuristic>(goal));
+    weighted.SetHeuristicWeight(bound);
+    weighted.SettleCost(goal);
+    ASSERT_TRUE(weighted.IsCostSettled(goal));
+    ASSERT_LE(weighted.GetCost(goal), bound * optimalCost + 1e-4);
+
+    Pathfinder<Point, NodesFocalList<Point>> focal(moves, origin, std::make_shared<EuclideanHeuristic>(goal));
+    focal.SetSuboptimalityBound(bound);
+    focal.SettleCost(goal);
+    ASSERT_TRUE(focal.IsCostSettled(goal));
+
+    // Every improvement pushes another entry, outdated entries are popped too
+    const SearchResult<Point>& focalStats = focal.GetStats();
+    ASSERT_EQ(focalStats.GetHeapPushesCount(), focalStats.GetGeneratedCount() + focalStats.GetImprovedCount());
+    ASSERT_GE(focalStats.GetHeapPopsCount(), focalStats.GetStepsCount());
+    ASSERT_LE(focal.GetCost(goal), bound * optimalCost + 1e-4);
+
+    if (bound == 1.f)
+    {
+      ASSERT_NEAR(focal.GetCost(goal), optimalCost, 1e-4);
+    }
+    else
+    {
+      ASSERT_LT(focal.GetStats().GetStepsCount(), optimal.GetStats().GetStepsCount());
+    }
+  }
+}
+
+TEST(PathfindingTests, BoundedSuboptimalWindowedSearch)
+{
+  std::mt19937 random(13);
+  std::shared_ptr<RawSpace> space(new RawSpace(40, 40));
+  ArrayType<Point> freePoints;
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 40; ++y)
+    {
+      if (random() % 5 == 0) continue;
+
+      space->SetAccess({ x, y }, Access::Accessable);
+      freePoints.push_back({ x, y });
+    }
+  }
+
+  // Goals are farther than the window reaches. Other agents have reserved cells for a while,
+  // so safe intervals of many cells end before the window does
+  Time depth = 16;
+  std::shared_ptr<SpaceTime> spaceTime = std::make_shared<SpaceTime>(depth, *space);
+  for (int i = 0; i < 400; ++i)
+  {
+    Time start = Time(random() % 12);
+    spaceTime->SetAccess(Area{ freePoints[random() % freePoints.size()], { start, start + 4 } }, Access::Inaccessable);
+  }
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  std::shared_ptr<ShapeSpace> agentSpace = std::make_shared<ShapeSpace>(depth, spaceTime, pointShape);
+  std::shared_ptr<SegmentMoves<EightConnectedMoves>> moves = std::make_shared<SegmentMoves<EightConnectedMoves>>(agentSpace, depth);
+  WindowedPathfinder<Area> optimal(moves, Area{ freePoints[0], {0, depth} }, nullptr, depth);
+  WindowedPathfinder<Area, NodesFocalList<Area, FocalByIntervalEnd>> focal(moves, Area{ freePoints[0], {0, depth} }, nullptr, depth);
+
+  // A windowed search stops at the end of the window, its cost is the time there plus the rest of the way
+  auto findWindowCost = [](const auto& search, Area destination, Point goal)
+  {
+    ArrayType<Node<Area>> path;
+    search.CollectPath(destination, path);
+
+    Point end = path.back().cell.point;
+    return path.back().minTime + std::sqrt(Time((end.x - goal.x) * (end.x - goal.x) + (end.y - goal.y) * (end.y - goal.y)));
+  };
+
+  size_t solvedCount = 0;
+  size_t suboptimalCount = 0;
+  for (int query = 0; query < 30; ++query)
+  {
+    Point start = freePoints[random() % freePoints.size()];
+    Point goal = freePoints[random() % freePoints.size()];
+    Area destination = Area::FromDepth(goal, depth);
+    std::shared_ptr<Heuristic<Area>> heuristic = std::make_shared<SpaceAdapter<Point, Area>>(std::make_shared<EuclideanHeuristic>(goal));
+
+    optimal.Reset({ start, {0, depth} }, heuristic);
+    optimal.FindCost(destination);
+    if (!optimal.IsCostFound(destination)) continue;
+
+    solvedCount++;
+    Time optimalCost = findWindowCost(optimal, destination, goal);
+    for (Time bound : { 1.f, 1.5f, 2.f })
+    {
+      focal.SetSuboptimalityBound(bound);
+      focal.Reset({ start, {0, depth} }, heuristic);
+      focal.FindCost(destination);
+      ASSERT_TRUE(focal.IsCostFound(destination));
+
+      Time focalCost = findWindowCost(focal, destination, goal);
+      ASSERT_LE(focalCost, bound * optimalCost + 1e-4);
+      if (bound == 1.f)
+      {
+        ASSERT_NEAR(focalCost, optimalCost, 1e-4);
+      }
+      else if (focalCost > optimalCost + 1e-4)
+      {
+        suboptimalCount++;
+      }
+    }
+  }
+
+  ASSERT_GT(solvedCount, 10);
+  // The criterion does change the order of expansions
+  ASSERT_GT(suboptimalCount, 0);
+}
+
+TEST(PathfindingTests, RollingHorizon)
+{
+  std::mt19937 random(5);
+  std::shared_ptr<RawSpace> space(new RawSpace(16, 16));
+  ArrayType<Point> freePoints;
+  for (int x = 0; x < 16; ++x)
+  {
+    for (int y = 0; y < 16; ++y)
+    {
+      // A wall with two doors in the middle of the map
+      if (x == 8 && y != 3 && y != 12) continue;
+
+      space->SetAccess({ x, y }, Access::Accessable);
+      freePoints.push_back({ x, y });
+    }
+  }
+
+  ArrayType<Point> goals;
+  for (int i = 0; i < 40; ++i)
+  {
+    goals.push_back(freePoints[random() % freePoints.size()]);
+  }
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  RollingHorizonEngine<> engine(space, pointShape, 10, 4, std::make_shared<GoalQueue>(goals));
+  ASSERT_TRUE(engine.AddAgent({ 0, 0 }));
+  ASSERT_TRUE(engine.AddAgent({ 15, 15 }));
+  ASSERT_TRUE(engine.AddAgent({ 0, 15 }));
+  ASSERT_TRUE(engine.AddAgent({ 15, 0 }));
+  ASSERT_FALSE(engine.AddAgent({ 0, 0 }));
+  ASSERT_FALSE(engine.AddAgent({ 8, 0 }));
+
+  size_t replanned = 0;
+  for (int tick = 0; tick < 400; ++tick)
+  {
+    const TickResult& result = engine.Tick(0.5f);
+    replanned += result.replannedAgents;
+    ASSERT_GE(result.planningTime, 0);
+
+    for (uint32_t first = 0; first < engine.GetAgentsCount(); ++first)
+    {
+      Point position = engine.GetAgentPosition(first);
+      ASSERT_TRUE(space->GetAccess(position) == Access::Accessable);
+      for (uint32_t second = first + 1; second < engine.GetAgentsCount(); ++second)
+      {
+        ASSERT_FALSE(position == engine.GetAgentPosition(second));
+      }
+    }
+  }
+
+  // Goals are reached one after another, agents are replanned only when needed
+  ASSERT_EQ(engine.GetTime(), 200);
+  ASSERT_EQ(engine.GetReachedGoals(), goals.size());
+  ASSERT_LT(replanned, 400 * engine.GetAgentsCount());
+  ASSERT_NEAR(engine.GetThroughput(), engine.GetReachedGoals() / 200.0, 1e-6);
+  for (uint32_t agent = 0; agent < engine.GetAgentsCount(); ++agent)
+  {
+    ASSERT_GT(engine.GetAgentGoalsReached(agent), 0);
+  }
+}
+
+// Exposes agents which wait for a replan
+class RollingHorizonProbe : public RollingHorizonEngine<>
+{
+public:
+  using RollingHorizonEngine<>::RollingHorizonEngine;
+
+  bool IsReplanPending(uint32_t agentId) const { return agents[agentId].needsReplan; }
+  bool IsAgentMoving(uint32_t agentId) const { return IsMoving(agents[agentId]); }
+};
+
+TEST(PathfindingTests, RollingHorizonNewGoalWhileMoving)
+{
+  // A crowded map, so agents pass through their goals while they make way for others
+  std::mt19937 random(0);
+  std::shared_ptr<RawSpace> space(new RawSpace(8, 8));
+  ArrayType<Point> freePoints;
+  for (int x = 0; x < 8; ++x)
+  {
+    for (int y = 0; y < 8; ++y)
+    {
+      if (random() % 5 == 0) continue;
+
+      space->SetAccess({ x, y }, Access::Accessable);
+      freePoints.push_back({ x, y });
+    }
+  }
+
+  ArrayType<Point> goals;
+  for (int i = 0; i < 60; ++i)
+  {
+    goals.push_back(freePoints[random() % freePoints.size()]);
+  }
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  RollingHorizonProbe engine(space, pointShape, 10, 4, std::make_shared<GoalQueue>(goals));
+  for (int i = 0; i < 8; ++i)
+  {
+    engine.AddAgent(freePoints[random() % freePoints.size()]);
+  }
+
+  // A new goal which comes in the middle of a move is kept until the move is finished
+  size_t pendingReplans = 0;
+  for (int tick = 0; tick < 200; ++tick)
+  {
+    const TickResult& result = engine.Tick(0.5f);
+    for (uint32_t agent = 0; agent < engine.GetAgentsCount(); ++agent)
+    {
+      if (!engine.IsReplanPending(agent)) continue;
+
+      ASSERT_TRUE(engine.IsAgentMoving(agent) || result.failedAgents > 0);
+      pendingReplans++;
+    }
+  }
+
+  // Only the last goals may be still on the way
+  ASSERT_GT(pendingReplans, 0);
+  ASSERT_GE(engine.GetReachedGoals(), goals.size() - engine.GetAgentsCount());
+}
+
+TEST(PathfindingTests, WindowedPathReservations)
+{
+  std::mt19937 random(7);
+  std::shared_ptr<RawSpace> space(new RawSpace(24, 24));
+  ArrayType<Point> freePoints;
+  for (int x = 0; x < 24; ++x)
+  {
+    for (int y = 0; y < 24; ++y)
+    {
+      if (random() % 4 == 0) continue;
+
+      space->SetAccess({ x, y }, Access::Accessable);
+      freePoints.push_back({ x, y });
+    }
+  }
+
+  Time depth = 60;
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  std::shared_ptr<RawSpace> footprints = std::make_shared<RawSpace>(ErodeByShape(*space, pointShape));
+  std::shared_ptr<SpaceTime> spaceTime = std::make_shared<SpaceTime>(depth, *space);
+  std::shared_ptr<ShapeSpace> agentSpace = std::make_shared<ShapeSpace>(depth, spaceTime, pointShape, footprints);
+  std::shared_ptr<SegmentMoves<EightConnectedMoves>> moves = std::make_shared<SegmentMoves<EightConnectedMoves>>(agentSpace, depth);
+  WindowedPathfinder<Area> pathfinder(moves, Area{ freePoints[0], {0, depth} }, nullptr, depth);
+
+  size_t improvedPaths = 0;
+  for (int query = 0; query < 30; ++query)
+  {
+    Point start = freePoints[random() % freePoints.size()];
+    Point goal = freePoints[random() % freePoints.size()];
+    Area destination = Area::FromDepth(goal, depth);
+    std::shared_ptr<Heuristic<Area>> heuristic = std::make_shared<SpaceAdapter<Point, Area>>(std::make_shared<EuclideanHeuristic>(goal));
+    pathfinder.Reset({ start, {0, depth} }, heuristic);
+    pathfinder.FindCost(destination);
+
+    // Nodes looked up through stale entries of the previous searches are not reused
+    WindowedPathfinder<Area> fresh(moves, Area{ start, {0, depth} }, heuristic, depth);
+    fresh.FindCost(destination);
+    ASSERT_EQ(pathfinder.IsCostFound(destination), fresh.IsCostFound(destination));
+    if (!pathfinder.IsCostFound(destination)) continue;
+    ASSERT_EQ(pathfinder.GetCost(destination), fresh.GetCost(destination));
+
+    ArrayType<Node<Area>> path;
+    pathfinder.CollectPath(destination, path);
+    if (pathfinder.GetStats().GetImprovedCount() > 0) improvedPaths++;
+
+    // Both cells are reserved while the agent moves between them, for exactly the length of the move,
+    // even if a node of the path was first reached by another move
+    ArrayType<Area> areas;
+    FromPathToFilledAreas(path, pointShape, areas);
+    ASSERT_EQ(areas.size(), path.size());
+    for (size_t j = 1; j < path.size(); ++j)
+    {
+      int dx = path[j].cell.point.x - path[j - 1].cell.point.x;
+      int dy = path[j].cell.point.y - path[j - 1].cell.point.y;
+      Time moveLength = std::sqrt(Time(dx * dx + dy * dy));
+      ASSERT_NEAR(areas[j - 1].interval.end - areas[j].interval.start, moveLength, 1e-4);
+      ASSERT_GE(areas[j].interval.start, path[j - 1].minTime - 1e-4);
+    }
+  }
+
+  ASSERT_GT(improvedPaths, 0);
+}
+
+TEST(PathfindingTests, SegmentMovesCornerCutting)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(6, 5));
+  for (int x = 0; x < 6; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      if ((x * 5 + y * 3) % 7 != 0) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Time depth = 20;
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  std::shared_ptr<SpaceTime> spaceTime = std::make_shared<SpaceTime>(depth, *space);
+  std::shared_ptr<ShapeSpace> agentSpace = std::make_shared<ShapeSpace>(depth, spaceTime, pointShape);
+  SegmentMoves<EightConnectedNoCornerCuttingMoves> moves(agentSpace, depth);
+  StaticGridMoves<EightConnectedNoCornerCuttingMoves> staticMoves(space);
+
+  // Without reservations moves over footprints are the same as over the grid
+  for (int x = 0; x < 6; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      if (space->GetAccess({ x, y }) != Access::Accessable) continue;
+
+      ArrayType<Move<Point>> expected = staticMoves.FindValidMoves(Node<Point>({ x, y }));
+      ArrayType<Move<Point>> actual = moves.FindValidMoves(Node<Point>({ x, y }));
+      ASSERT_EQ(expected.size(), actual.size());
+      for (size_t i = 0; i < expected.size(); ++i)
+      {
+        ASSERT_EQ(expected[i].destination, actual[i].destination);
+      }
+    }
+  }
+
+  // The diagonal move from (1, 1) to (2, 2) waits until the corner (2, 1) is free
+  ASSERT_EQ(space->GetAccess({ 2, 1 }), Access::Accessable);
+  ASSERT_EQ(space->GetAccess({ 1, 2 }), Access::Accessable);
+  ASSERT_EQ(space->GetAccess({ 2, 2 }), Access::Accessable);
+  spaceTime->SetAccess(Area{ { 2, 1 }, { 0, 3 } }, Access::Inaccessable);
+
+  Node<Area> node(Area{ { 1, 1 }, { 0, depth } }, 0, 0);
+  bool isDiagonalFound = false;
+  for (const Move<Area>& move : moves.FindValidMoves(node))
+  {
+    if (!(move.destination.point == Point{ 2, 2 })) continue;
+
+    isDiagonalFound = true;
+    ASSERT_NEAR(move.cost, 3 + DIAGONAL_MOVE_COST, 1e-4);
+  }
+  ASSERT_TRUE(isDiagonalFound);
+
+  SegmentMoves<EightConnectedMoves> cuttingMoves(agentSpace, depth);
+  for (const Move<Area>& move : cuttingMoves.FindValidMoves(node))
+  {
+    if (move.destination.point == Point{ 2, 2 })
+    {
+      ASSERT_NEAR(move.cost, DIAGONAL_MOVE_COST, 1e-4);
+    }
+  }
+}
+
+TEST(PathfindingTests, SpeculativePlanner)
+{
+  std::mt19937 random(3);
+  std::shared_ptr<RawSpace> space(new RawSpace(24, 24));
+  for (int x = 0; x < 24; ++x)
+  {
+    for (int y = 0; y < 24; ++y)
+    {
+      if (random() % 7) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Time depth = 40;
+  Shape crossShape = { ArrayType<Point>{ {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0} } };
+  std::shared_ptr<RawSpace> footprints = std::make_shared<RawSpace>(ErodeByShape(*space, crossShape));
+  ArrayType<Point> freeFootprints;
+  for (int x = 0; x < 24; ++x)
+  {
+    for (int y = 0; y < 24; ++y)
+    {
+      if (footprints->GetAccess({ x, y }) == Access::Accessable) freeFootprints.push_back({ x, y });
+    }
+  }
+
+  // Starts are reserved like in mapf_vis, each agent frees its start before planning
+  std::shared_ptr<SpaceTime> sequentialSpace = std::make_shared<SpaceTime>(depth, *space);
+  ArrayType<PlanningTask> tasks;
+  for (int i = 0; i < 16; ++i)
+  {
+    Point start = freeFootprints[random() % freeFootprints.size()];
+    Point goal = freeFootprints[random() % freeFootprints.size()];
+    if (!sequentialSpace->GetSegments(start).Contains({ 0, depth })) continue;
+
+    sequentialSpace->SetAccess({ start, {0, depth} }, Access::Inaccessable);
+    tasks.push_back({ start, goal, std::make_shared<SpaceAdapter<Point, Area>>(std::make_shared<EuclideanHeuristic>(goal)) });
+  }
+  std::shared_ptr<SpaceTime> speculativeSpace = std::make_shared<SpaceTime>(*sequentialSpace);
+
+  ArrayType<PlanningResult> sequentialResults(tasks.size());
+  {
+    std::shared_ptr<ShapeSpace> agentSpace = std::make_shared<ShapeSpace>(depth, sequentialSpace, crossShape, footprints);
+    std::shared_ptr<SegmentMoves<EightConnectedMoves>> moves = std::make_shared<SegmentMoves<EightConnectedMoves>>(agentSpace, depth);
+    WindowedPathfinder<Area> pathfinder(moves, Area{ tasks[0].start, {0, depth} }, nullptr, depth);
+
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+      Area origin = { tasks[i].start, {0, depth} };
+      Area destination = Area::FromDepth(tasks[i].goal, depth);
+      sequentialSpace->SetAccess(origin, Access::Accessable);
+      pathfinder.Reset(origin, tasks[i].heuristic);
+      pathfinder.FindCost(destination);
+
+      sequentialResults[i].isFound = pathfinder.IsCostFound(destination);
+      if (!sequentialResults[i].isFound)
+      {
+        sequentialSpace->SetAccess(origin, Access::Inaccessable);
+        continue;
+      }
+
+      ArrayType<Area> areas;
+      pathfinder.CollectPath(destination, sequentialResults[i].path);
+      FromPathToFilledAreas(sequentialResults[i].path, crossShape, areas);
+      sequentialSpace->MakeAreasInaccessable(areas);
+    }
+  }
+
+  ThreadPool threadPool(4);
+  SpeculativePlanner<EightConnectedMoves> planner(speculativeSpace, crossShape, footprints, depth);
+  ArrayType<PlanningResult> speculativeResults;
+  planner.PlanAll(tasks, speculativeResults, threadPool);
+
+  // Paths and reservations are the same as after sequential planning
+  ASSERT_EQ(speculativeResults.size(), tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i)
+  {
+    ASSERT_EQ(speculativeResults[i].isFound, sequentialResults[i].isFound);
+    ASSERT_EQ(speculativeResults[i].path.size(), sequentialResults[i].path.size());
+    for (size_t j = 0; j < sequentialResults[i].path.size(); ++j)
+    {
+      ASSERT_EQ(speculativeResults[i].path[j].cell, sequentialResults[i].path[j].cell);
+      ASSERT_EQ(speculativeResults[i].path[j].minTime, sequentialResults[i].path[j].minTime);
+    }
+  }
+
+  for (Point point : freeFootprints)
+  {
+    ASSERT_TRUE(speculativeSpace->GetSegments(point) == sequentialSpace->GetSegments(point));
+  }
+  ASSERT_LT(planner.GetConflictsCount(), tasks.size());
+}
+
+TEST(PathfindingTests, FindCosts)
+{
+  std::mt19937 random(17);
+  std::shared_ptr<RawSpace> space(new RawSpace(30, 30));
+  for (int x = 0; x < 30; ++x)
+  {
+    for (int y = 0; y < 30; ++y)
+    {
+      if (random() % 4) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Point origin = { 0, 0 };
+  space->SetAccess(origin, Access::Accessable);
+  std::shared_ptr<StaticGridMoves<EightConnectedMoves>> moves = std::make_shared<StaticGridMoves<EightConnectedMoves>>(space);
+
+  // Targets include blocked cells, cells outside of the map and repeated cells
+  ArrayType<Point> targets = { { 40, 40 }, origin };
+  for (int i = 0; i < 60; ++i)
+  {
+    targets.push_back({ (int) (random() % 30), (int) (random() % 30) });
+  }
+  targets.push_back(targets[5]);
+
+  Pathfinder<Point> batch(moves, origin, std::make_shared<Heuristic<Point>>(origin));
+  batch.SetGridBounds(30, 30);
+  ArrayType<Time> costs;
+  ArrayType<ArrayType<Node<Point>>> paths;
+  batch.FindCosts(targets, costs, std::numeric_limits<Time>::max(), &paths);
+
+  Pathfinder<Point> all(moves, origin, std::make_shared<Heuristic<Point>>(origin));
+  all.SettleAll();
+  ASSERT_LE(batch.GetStats().GetStepsCount(), all.GetStats().GetStepsCount());
+
+  ASSERT_EQ(costs.size(), targets.size());
+  for (size_t i = 0; i < targets.size(); ++i)
+  {
+    Pathfinder<Point> single(moves, origin, std::make_shared<EuclideanHeuristic>(targets[i]));
+    single.SettleCost(targets[i]);
+    if (!single.IsCostSettled(targets[i]))
+    {
+      ASSERT_EQ(costs[i], UNREACHED_COST);
+      ASSERT_TRUE(paths[i].empty());
+      continue;
+    }
+
+    ASSERT_NEAR(costs[i], single.GetCost(targets[i]), 1e-4);
+    ASSERT_EQ(paths[i].front().cell, origin);
+    ASSERT_EQ(paths[i].back().cell, targets[i]);
+  }
+
+  // Targets beyond the bound are not reported, the search can be continued
+  Time bound = 8;
+  Pathfinder<Point> bounded(moves, origin, std::make_shared<Heuristic<Point>>(origin));
+  ArrayType<Time> boundedCosts;
+  bounded.FindCosts(targets, boundedCosts, bound);
+  for (size_t i = 0; i < targets.size(); ++i)
+  {
+    ASSERT_EQ(boundedCosts[i], costs[i] <= bound ? costs[i] : UNREACHED_COST);
+  }
+
+  bounded.FindCosts(targets, boundedCosts);
+  ASSERT_EQ(boundedCosts, costs);
+}
+
+TEST(PathfindingTests, BidirectionalPathfinder)
+{
+  std::mt19937 random(23);
+  std::shared_ptr<RawSpace> space(new RawSpace(40, 40));
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 40; ++y)
+    {
+      if (random() % 3) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  std::shared_ptr<StaticGridMoves<EightConnectedMoves>> moves = std::make_shared<StaticGridMoves<EightConnectedMoves>>(space);
+  BidirectionalPathfinder<> bidirectional(moves, { 0, 0 }, { 0, 0 }, nullptr, nullptr);
+  bidirectional.SetGridBounds(40, 40);
+
+  ArrayType<Node<Point>> path;
+  for (int i = 0; i < 50; ++i)
+  {
+    Point origin = { (int) (random() % 40), (int) (random() % 40) };
+    Point goal = i == 0 ? origin : Point{ (int) (random() % 40), (int) (random() % 40) };
+    space->SetAccess(origin, Access::Accessable);
+    space->SetAccess(goal, Access::Accessable);
+
+    Pathfinder<Point> single(moves, origin, std::make_shared<EuclideanHeuristic>(goal));
+    single.FindCost(goal);
+
+    bidirectional.Reset(origin, goal, std::make_shared<EuclideanHeuristic>(goal), std::make_shared<EuclideanHeuristic>(origin));
+    bidirectional.FindCost(goal);
+    bidirectional.CollectPath(goal, path);
+
+    ASSERT_EQ(bidirectional.IsCostFound(goal), single.IsCostFound(goal));
+    if (!single.IsCostFound(goal))
+    {
+      ASSERT_TRUE(path.empty());
+      continue;
+    }
+
+    ASSERT_NEAR(bidirectional.GetCost(goal), single.GetCost(goal), 1e-4);
+    if (!(origin == goal))
+    {
+      // Only the goal has a cost
+      bidirectional.FindCost(origin);
+      ASSERT_FALSE(bidirectional.IsCostFound(origin));
+    }
+
+    ASSERT_EQ(path.front().cell, origin);
+    ASSERT_EQ(path.back().cell, goal);
+    ASSERT_NEAR(path.back().minTime, bidirectional.GetCost(goal), 1e-4);
+    for (size_t j = 1; j < path.size(); ++j)
+    {
+      Point delta = { path[j].cell.x - path[j - 1].cell.x, path[j].cell.y - path[j - 1].cell.y };
+      Time moveCost = delta.x && delta.y ? DIAGONAL_MOVE_COST : 1;
+      ASSERT_TRUE(std::abs(delta.x) <= 1 && std::abs(delta.y) <= 1);
+      ASSERT_NEAR(path[j].minTime - path[j - 1].minTime, moveCost, 1e-4);
+      ASSERT_NEAR(path[j].arrivalCost, moveCost, 1e-4);
+    }
+  }
+
+  // A walled in goal exhausts the backward side at once, A* searches the whole region of the origin
+  Point origin = { 2, 2 };
+  Point goal = { 20, 20 };
+  space->SetAccess(origin, Access::Accessable);
+  space->SetAccess(goal, Access::Accessable);
+  for (const Point& offset : RawSpace::NeighborOffsets)
+  {
+    space->SetAccess({ goal.x + offset.x, goal.y + offset.y }, Access::Inaccessable);
+  }
+
+  Pathfinder<Point> single(moves, origin, std::make_shared<EuclideanHeuristic>(goal));
+  single.FindCost(goal);
+  bidirectional.Reset(origin, goal, std::make_shared<EuclideanHeuristic>(goal), std::make_shared<EuclideanHeuristic>(origin));
+  bidirectional.FindCost(goal);
+  ASSERT_FALSE(single.IsCostFound(goal));
+  ASSERT_FALSE(bidirectional.IsCostFound(goal));
+  ASSERT_LT(bidirectional.GetStepsCount() * 10, single.GetStats().GetStepsCount());
+}
+
+TEST(PathfindingTests, ClusterGraph)
+{
+  std::mt19937 random(29);
+  std::shared_ptr<RawSpace> space(new RawSpace(37, 41));
+  for (int x = 0; x < 37; ++x)
+  {
+    for (int y = 0; y < 41; ++y)
+    {
+      if (random() % 4) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  ArrayType<Move<Point>> moves = MakeMoves<EightConnectedMoves>();
+  Shape shape = { ArrayType<Point>{ {0, 0}, {1, 0} } };
+  std::shared_ptr<GridMoves> gridMoves = std::make_shared<GridMoves>(space, shape, moves);
+  std::shared_ptr<ClusterGraph> graph = std::make_shared<ClusterGraph>(space, shape, moves, 8);
+  ASSERT_EQ(graph->GetClustersCount(), 5 * 6);
+
+  auto checkQueries = [&](std::shared_ptr<ClusterGraph> testedGraph, std::mt19937 queries)
+  {
+    ArrayType<Node<Point>> path;
+    for (int i = 0; i < 20; ++i)
+    {
+      Point from = { (int) (queries() % 37), (int) (queries() % 41) };
+      Point to = { (int) (queries() % 37), (int) (queries() % 41) };
+
+      Pathfinder<Point> exact(gridMoves, to, std::make_shared<Heuristic<Point>>(to));
+      exact.SettleAll();
+
+      // Abstract costs are costs of real paths and there is one whenever the cells are connected
+      bool isFound = testedGraph->FindPath(from, to, path);
+      ASSERT_EQ(isFound, gridMoves->IsValid(from) && gridMoves->IsValid(to) && exact.IsCostSettled(from));
+      if (!isFound) continue;
+
+      ASSERT_EQ(path.front().cell, from);
+      ASSERT_EQ(path.back().cell, to);
+      ASSERT_GE(path.back().minTime, exact.GetCost(from) - 1e-4);
+      ASSERT_LE(path.back().minTime, exact.GetCost(from) * 1.5f);
+      for (size_t j = 1; j < path.size(); ++j)
+      {
+        Point delta = { path[j].cell.x - path[j - 1].cell.x, path[j].cell.y - path[j - 1].cell.y };
+        ASSERT_TRUE(std::abs(delta.x) <= 1 && std::abs(delta.y) <= 1);
+        ASSERT_TRUE(gridMoves->IsValid(path[j].cell));
+        ASSERT_NEAR(path[j].minTime - path[j - 1].minTime, path[j].arrivalCost, 1e-4);
+      }
+
+      HierarchicalHeuristic heuristic(testedGraph, to);
+      heuristic.FindCost(to);
+      ASSERT_TRUE(heuristic.IsCostFound(to));
+      ASSERT_EQ(heuristic.GetCost(to), 0);
+      for (const Node<Point>& node : path)
+      {
+        heuristic.FindCost(node.cell);
+        ASSERT_TRUE(heuristic.IsCostFound(node.cell));
+        ASSERT_GE(heuristic.GetCost(node.cell), exact.GetCost(node.cell) - 1e-4);
+      }
+    }
+  };
+
+  checkQueries(graph, std::mt19937(31));
+
+  // A heuristic made before the update, with costs of every cell found
+  Point heuristicGoal = { 18, 20 };
+  HierarchicalHeuristic oldHeuristic(graph, heuristicGoal);
+  for (int x = 0; x < 37; ++x)
+  {
+    for (int y = 0; y < 41; ++y)
+    {
+      oldHeuristic.FindCost({ x, y });
+    }
+  }
+
+  // Cells of several clusters change, a row across the map is freed
+  ArrayType<Point> changed;
+  for (int i = 0; i < 40; ++i)
+  {
+    Point cell = { (int) (random() % 37), (int) (random() % 41) };
+    space->SetAccess(cell, i % 2 ? Access::Accessable : Access::Inaccessable);
+    changed.push_back(cell);
+  }
+
+  for (int x = 0; x < 37; ++x)
+  {
+    space->SetAccess({ x, 20 }, Access::Accessable);
+    changed.push_back({ x, 20 });
+  }
+
+  // Updated clusters are the same as built from scratch
+  graph->UpdateCells(changed);
+  std::shared_ptr<ClusterGraph> rebuilt = std::make_shared<ClusterGraph>(space, shape, moves, 8);
+  ASSERT_EQ(graph->GetEntrancesCount(), rebuilt->GetEntrancesCount());
+  for (uint32_t clusterIndex = 0; clusterIndex < graph->GetClustersCount(); ++clusterIndex)
+  {
+    ASSERT_EQ(graph->GetEntrances(clusterIndex), rebuilt->GetEntrances(clusterIndex));
+    const ArrayType<Time>& distances = graph->GetDistances(clusterIndex);
+    const ArrayType<Time>& rebuiltDistances = rebuilt->GetDistances(clusterIndex);
+    ASSERT_EQ(distances.size(), rebuiltDistances.size());
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+      ASSERT_NEAR(distances[i], rebuiltDistances[i], 1e-4);
+    }
+  }
+
+  // The old heuristic finds the costs of the updated graph
+  HierarchicalHeuristic newHeuristic(rebuilt, heuristicGoal);
+  for (int x = 0; x < 37; ++x)
+  {
+    for (int y = 0; y < 41; ++y)
+    {
+      oldHeuristic.FindCost({ x, y });
+      newHeuristic.FindCost({ x, y });
+      ASSERT_EQ(oldHeuristic.IsCostFound({ x, y }), newHeuristic.IsCostFound({ x, y }));
+      if (newHeuristic.IsCostFound({ x, y }))
+      {
+        ASSERT_NEAR(oldHeuristic.GetCost({ x, y }), newHeuristic.GetCost({ x, y }), 1e-4);
+      }
+    }
+  }
+  checkQueries(graph, std::mt19937(37));
+  checkQueries(rebuilt, std::mt19937(37));
+
+  // A* guided by the abstraction expands fewer nodes than Dijkstra and finds a path of about the same cost
+  Point origin = { 0, 20 };
+  Point goal = { 35, 20 };
+  Pathfinder<Point> exact(gridMoves, origin, std::make_shared<Heuristic<Point>>(goal));
+  exact.SettleCost(goal);
+  Pathfinder<Point> guided(gridMoves, origin, std::make_shared<HierarchicalHeuristic>(graph, goal));
+  guided.SettleCost(goal);
+  ASSERT_TRUE(guided.IsCostSettled(goal));
+  ASSERT_LE(guided.GetStats().GetStepsCount(), exact.GetStats().GetStepsCount());
+  ASSERT_LE(guided.GetCost(goal), exact.GetCost(goal) * 1.5f);
+}
+
+TEST(PathfindingTests, HeuristicCache)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(5, 5));
+  for (int x = 0; x < 5; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      if (x != 2 || y == 4) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  ArrayType<Move<Point>> moves =
+  {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+  };
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  Shape wideShape = { ArrayType<Point>{ {0, 0}, {0, -1} } };
+  HeuristicCache cache(space, moves, 2);
+
+  std::shared_ptr<TrueDistanceHeuristic> h = cache.Get({ 0, 0 }, pointShape);
+  ASSERT_EQ(h, cache.Get({ 0, 0 }, pointShape));
+  ASSERT_EQ(h->GetOrigin(), Point(0, 0));
+
+  h->FindCost({ 4, 0 });
+  ASSERT_TRUE(h->IsCostFound({ 4, 0 }));
+  ASSERT_EQ(h->GetCost({ 4, 0 }), 12);
+  h->FindCost({ 1, 1 });
+  ASSERT_EQ(h->GetCost({ 1, 1 }), 2);
+
+  // The wide shape cannot pass through the gap in the wall
+  std::shared_ptr<TrueDistanceHeuristic> wide = cache.Get({ 0, 0 }, wideShape);
+  ASSERT_NE(h, wide);
+  wide->FindCost({ 3, 0 });
+  ASSERT_FALSE(wide->IsCostFound({ 3, 0 }));
+
+  // The least recently used heuristic is evicted, but stays valid for its holders
+  cache.Get({ 0, 0 }, pointShape);
+  cache.Get({ 4, 4 }, pointShape);
+  ASSERT_EQ(cache.Size(), 2);
+  ASSERT_EQ(h, cache.Get({ 0, 0 }, pointShape));
+  ASSERT_NE(wide, cache.Get({ 0, 0 }, wideShape));
+  wide->FindCost({ 1, 1 });
+  ASSERT_EQ(wide->GetCost({ 1, 1 }), 2);
+}
+
+TEST(PathfindingTests, ThreadPool)
+{
+  ThreadPool threadPool(4);
+  ASSERT_EQ(threadPool.GetThreadsCount(), 4);
+
+  for (size_t count : { 0, 1, 3, 1000 })
+  {
+    ArrayType<int> visits(count, 0);
+    threadPool.ParallelFor(count, [&visits](size_t index) { visits[index]++; });
+    ASSERT_EQ(std::count(visits.begin(), visits.end(), 1), (int) count);
+  }
+}
+
+TEST(PathfindingTests, HeuristicCachePrecompute)
+{
+  std::shared_ptr<RawSpace> space(new RawSpace(6, 6));
+  for (int x = 0; x < 6; ++x)
+  {
+    for (int y = 0; y < 6; ++y)
+    {
+      if (x != 3 || y == 0) space->SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  ArrayType<Move<Point>> moves =
+  {
+    Move<Point>{ 1, {0, 1}},
+    Move<Point>{ 1, {0, -1}},
+    Move<Point>{ 1, {1, 0}},
+    Move<Point>{ 1, {-1, 0}},
+  };
+
+  Shape pointShape = { ArrayType<Point>{ {0, 0} } };
+  HeuristicCache cache(space, moves, 8);
+  HeuristicCache lazyCache(space, moves, 8);
+  ThreadPool threadPool(3);
+
+  ArrayType<DistanceTableKey> keys = { { {0, 5}, pointShape }, { {5, 5}, pointShape }, { {0, 5}, pointShape } };
+  auto heuristics = cache.Precompute(keys, threadPool);
+  ASSERT_EQ(heuristics.size(), keys.size());
+  ASSERT_EQ(heuristics[0], heuristics[2]);
+  ASSERT_EQ(cache.Size(), 2);
+
+  for (size_t i = 0; i < keys.size(); ++i)
+  {
+    auto lazy = lazyCache.Get(keys[i].goal, keys[i].shape);
+    for (int x = 0; x < 6; ++x)
+    {
+      for (int y = 0; y < 6; ++y)
+      {
+        lazy->FindCost({ x, y });
+        ASSERT_EQ(heuristics[i]->IsCostFound({ x, y }), lazy->IsCostFound({ x, y }));
+        if (!lazy->IsCostFound({ x, y })) continue;
+        ASSERT_EQ(heuristics[i]->GetCost({ x, y }), lazy->GetCost({ x, y }));
+      }
+    }
+  }
+}
+
 TEST(PathfindingTests, SegmentMap)
 {
   std::shared_ptr<RawSpace> space(new RawSpace(3, 3));
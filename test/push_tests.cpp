@@ -6,6 +6,8 @@
 #include <optional>
 #include "nodes_heap.h"
 #include "shapes.h"
+#include <atomic>
+#include <thread>
 #include <gtest/gtest.h>
 
 // TODO add segment & operation with dots (for example, {0, 0} and {-1, 1})
@@ -20,6 +22,44 @@ TEST(SpaceTests, Construction)
   ASSERT_EQ(space.GetWidth(), 3);
 }
 
+TEST(SpaceTests, RawSpaceWordQueries)
+{
+  // Rows are wider than a word, so queries cross word borders
+  RawSpace space(130, 3);
+  for (int x = 0; x < 130; ++x)
+  {
+    for (int y = 0; y < 3; ++y)
+    {
+      if (x != 70 && x != 100) space.SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+  space.SetAccess({ 63, 0 }, Access::Inaccessable);
+
+  ASSERT_EQ(space.GetAccess({ 64, 0 }), Access::Accessable);
+  ASSERT_EQ(space.GetAccess({ 63, 0 }), Access::Inaccessable);
+
+  ASSERT_TRUE(space.IsSpanAccessable({ 0, 1 }, 70));
+  ASSERT_FALSE(space.IsSpanAccessable({ 0, 1 }, 71));
+  ASSERT_FALSE(space.IsSpanAccessable({ 120, 1 }, 11));
+  ASSERT_TRUE(space.IsSpanAccessable({ 101, 2 }, 29));
+
+  ASSERT_EQ(space.FindInaccessableInRow({ 0, 1 }, 1), 70);
+  ASSERT_EQ(space.FindInaccessableInRow({ 71, 1 }, 1), 100);
+  ASSERT_EQ(space.FindInaccessableInRow({ 101, 1 }, 1), 130);
+  ASSERT_EQ(space.FindInaccessableInRow({ 99, 1 }, -1), 70);
+  ASSERT_EQ(space.FindInaccessableInRow({ 69, 1 }, -1), -1);
+  ASSERT_EQ(space.FindInaccessableInRow({ 69, 0 }, -1), 63);
+
+  ASSERT_EQ(space.GetAccessableNeighbors({ 64, 1 }), 0b11111110);
+  ASSERT_EQ(space.GetAccessableNeighbors({ 0, 0 }), 0b11010000);
+  ASSERT_EQ(space.GetAccessableNeighbors({ 69, 1 }), 0b01101011);
+
+  ArrayType<Point> cross = { {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0} };
+  ASSERT_TRUE(space.AreAllAccessable({ 65, 1 }, cross));
+  ASSERT_FALSE(space.AreAllAccessable({ 63, 1 }, cross));
+  ASSERT_FALSE(space.AreAllAccessable({ 5, 0 }, cross));
+}
+
 TEST(SpaceTests, ReadHogFormat)
 {
   SpaceReader reader;
@@ -44,6 +84,36 @@ TEST(SpaceTests, ReadHogFormat)
   }
 }
 
+TEST(SpaceTests, ReadHogTerrainAndLineEndings)
+{
+  std::string map = "type octile\r\nheight 2\r\nwidth 4\r\nmap\r\n.GST\r\nW@O.";
+
+  SpaceReader reader;
+  std::optional<RawSpace> space = reader.FromHogFormat(map.data(), map.size());
+  ASSERT_TRUE(space.has_value());
+  ASSERT_EQ(space.value().GetWidth(), 4);
+  ASSERT_EQ(space.value().GetHeight(), 2);
+
+  Access a = Access::Accessable;
+  Access n = Access::Inaccessable;
+  Access expected[2][4] = { { a, a, a, n }, { n, n, n, a } };
+  for (int y = 0; y < 2; ++y)
+  {
+    for (int x = 0; x < 4; ++x)
+    {
+      ASSERT_EQ(space.value().GetAccess({ x, y }), expected[y][x]);
+    }
+  }
+
+  std::string truncated = "type octile\nheight 2\nwidth 4\nmap\n....\n..";
+  ASSERT_FALSE(reader.FromHogFormat(truncated.data(), truncated.size()).has_value());
+
+  std::optional<RawSpace> mapped = reader.FromHogFile(TEST_DATA_PATH "/chess_like.map");
+  ASSERT_TRUE(mapped.has_value());
+  ASSERT_EQ(mapped.value().GetAccess({ 0, 0 }), Access::Accessable);
+  ASSERT_EQ(mapped.value().GetAccess({ 1, 0 }), Access::Inaccessable);
+}
+
 TEST(SpaceTests, SegmentSpaceConstruction)
 {
   Time depth = 3;
@@ -64,6 +134,27 @@ TEST(SpaceTests, SegmentSpaceConstruction)
   ASSERT_EQ(test.GetSegments({ 1, 1 }), newHolder);
 }
 
+TEST(SpaceTests, SegmentSpaceOutsideOfGrid)
+{
+  Time depth = 3;
+  RawSpace space(2, 2);
+  space.SetAccess({ 1, 0 }, Access::Accessable);
+
+  SegmentSpace test(depth, space);
+  ASSERT_EQ(test.GetWidth(), 2);
+  ASSERT_EQ(test.GetHeight(), 2);
+  ASSERT_FALSE(test.ContainsSegmentsIn({ -1, 0 }));
+  ASSERT_FALSE(test.ContainsSegmentsIn({ 0, 5 }));
+
+  SegmentHolder newHolder({ 1, 2 });
+  test.SetSegments({ -1, 0 }, newHolder);
+  ASSERT_TRUE(test.ContainsSegmentsIn({ -1, 0 }));
+  ASSERT_EQ(test.GetSegments({ -1, 0 }), newHolder);
+  ASSERT_TRUE(test.Contains(Area{ { -1, 0 }, { 1, 2 } }));
+  ASSERT_TRUE(test.Contains(Area{ { 1, 0 }, { 0, 3 } }));
+  ASSERT_FALSE(test.Contains(Area{ { 0, 0 }, { 0, 3 } }));
+}
+
 TEST(SpaceTests, MakeAreasInaccessable)
 {
   Time depth = 3;
@@ -121,6 +212,116 @@ TEST(SpaceTimeTests, MoveTime)
   ASSERT_EQ(spaceTime.GetSegments({ 2, 2 }), result2);
 }
 
+TEST(SpaceTimeTests, MoveTimeLazily)
+{
+  Time depth = 10;
+  RawSpace space(2, 2);
+  space.SetAccess({ 0, 0 }, Access::Accessable);
+  space.SetAccess({ 1, 1 }, Access::Accessable);
+  SpaceTime spaceTime(depth, space);
+
+  spaceTime.MakeAreasInaccessable({ Area{{0, 0}, {2, 4}} });
+  spaceTime.MoveTime(1);
+  spaceTime.MoveTime(2);
+
+  SegmentHolder result1;
+  result1.AddSegment({ 1, 10 });
+  ASSERT_EQ(spaceTime.GetSegments({ 0, 0 }), result1);
+
+  spaceTime.SetSegments({ 1, 1 }, SegmentHolder({ 0, 5 }));
+  spaceTime.MoveTime(1);
+
+  SegmentHolder result2;
+  result2.AddSegment({ 0, 4 });
+  result2.AddSegment({ 9, 10 });
+  ASSERT_EQ(spaceTime.GetSegments({ 1, 1 }), result2);
+  ASSERT_TRUE(spaceTime.Contains(Area{ { 0, 0 }, { 0, 10 } }));
+}
+
+TEST(SpaceTimeTests, SegmentSnapshots)
+{
+  Time depth = 10;
+  RawSpace space(40, 20);
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 20; ++y)
+    {
+      if (x != 20) space.SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  std::shared_ptr<SpaceTime> spaceTime = std::make_shared<SpaceTime>(depth, space);
+  SegmentSpacePublisher publisher(spaceTime);
+  std::shared_ptr<const SegmentSnapshot> first = publisher.GetSnapshot();
+  ASSERT_EQ(first->GetVersion(), 0);
+  ASSERT_EQ(first->GetTiles().size(), 6);
+  ASSERT_FALSE(first->ContainsSegmentsIn({ 20, 5 }));
+  ASSERT_FALSE(first->ContainsSegmentsIn({ 40, 5 }));
+  ASSERT_EQ(first->GetSegments({ 39, 19 }), SegmentHolder(Segment{ 0, depth }));
+  ASSERT_EQ(publisher.Publish(), first);
+
+  // Old versions stay as they were, unchanged tiles are shared
+  spaceTime->MakeAreasInaccessable({ Area{{ 35, 18 }, { 2, 4 }} });
+  std::shared_ptr<const SegmentSnapshot> second = publisher.Publish();
+  SegmentHolder reserved(Segment{ 0, depth });
+  reserved.RemoveSegment({ 2, 4 });
+  ASSERT_EQ(second->GetVersion(), 1);
+  ASSERT_EQ(second->GetSegments({ 35, 18 }), reserved);
+  ASSERT_EQ(first->GetSegments({ 35, 18 }), SegmentHolder(Segment{ 0, depth }));
+  for (size_t tile = 0; tile < second->GetTiles().size(); ++tile)
+  {
+    ASSERT_EQ(second->IsTileShared(*first, tile), tile != 5);
+  }
+
+  spaceTime->MoveTime(3);
+  std::shared_ptr<const SegmentSnapshot> third = publisher.Publish();
+  ASSERT_EQ(third->GetSegments({ 35, 18 }), spaceTime->GetSegments({ 35, 18 }));
+  ASSERT_EQ(third->GetSegments({ 0, 0 }), SegmentHolder(Segment{ 0, depth }));
+
+  // Readers take versions while the writer keeps reserving and publishing
+  std::atomic<bool> isWriting{ true };
+  std::atomic<size_t> failedReads{ 0 };
+  ArrayType<std::thread> readers;
+  for (int i = 0; i < 3; ++i)
+  {
+    readers.emplace_back([&]()
+    {
+      uint64_t lastVersion = 0;
+      while (isWriting)
+      {
+        std::shared_ptr<const SegmentSnapshot> snapshot = publisher.GetSnapshot();
+        if (snapshot->GetVersion() < lastVersion) failedReads++;
+        lastVersion = snapshot->GetVersion();
+
+        // Every version reserves whole columns at once
+        for (int y = 0; y < 20; ++y)
+        {
+          if (!(snapshot->GetSegments({ 0, y }) == snapshot->GetSegments({ 0, 0 }))) failedReads++;
+        }
+      }
+    });
+  }
+
+  for (int step = 0; step < 200; ++step)
+  {
+    ArrayType<Area> areas;
+    for (int y = 0; y < 20; ++y)
+    {
+      areas.push_back(Area{ { 0, y }, { step * 0.04f, step * 0.04f + 0.01f } });
+    }
+    spaceTime->MakeAreasInaccessable(areas);
+    publisher.Publish();
+  }
+  isWriting = false;
+  for (std::thread& reader : readers)
+  {
+    reader.join();
+  }
+
+  ASSERT_EQ(failedReads, 0);
+  ASSERT_EQ(publisher.GetSnapshot()->GetSegments({ 0, 19 }), spaceTime->GetSegments({ 0, 19 }));
+}
+
 TEST(SegmentsTests, Intersection)
 {
   Segment b{ 0, 10 };
@@ -355,6 +556,31 @@ TEST(SegmentHolderTests, Reduction)
   ASSERT_EQ(segments, answer);
 }
 
+TEST(SegmentHolderTests, BeyondInlineCapacity)
+{
+  SegmentHolder segments;
+  std::vector<Segment> answer;
+  for (int i = 9; i >= 0; --i)
+  {
+    segments.AddSegment({ Time(3 * i), Time(3 * i + 1) });
+  }
+  for (int i = 0; i < 10; ++i)
+  {
+    answer.push_back({ Time(3 * i), Time(3 * i + 1) });
+  }
+  SegmentsAdditionWithCheck(segments, answer, {});
+
+  SegmentHolder segmentsCopy = segments;
+  ASSERT_EQ(segmentsCopy, segments);
+
+  segmentsCopy.RemoveSegment({ 2, 24.5 });
+  SegmentsAdditionWithCheck(segmentsCopy, { {0, 1}, {24.5, 25}, {27, 28} }, {});
+  SegmentsAdditionWithCheck(segments, answer, {});
+
+  segments.AddSegment({ -1, 30 });
+  SegmentsAdditionWithCheck(segments, { {-1, 30} }, {});
+}
+
 TEST(AgentTest, MakeAgentSpace)
 {
   // TODO remove simplification
@@ -384,9 +610,194 @@ TEST(AgentTest, MakeAgentSpace)
   }
 }
 
-TEST(NodesBinaryHeap, CheckTies)
+TEST(AgentTest, ShapeSpaceFollowsReservations)
 {
-  NodesBinaryHeap<int> heap(true);
+  RawSpace baseSpace(5, 5);
+  for (int x = 0; x < 5; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      baseSpace.SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Time depth = 10;
+  std::shared_ptr<SegmentSpace> space = std::make_shared<SegmentSpace>(depth, baseSpace);
+  Shape shape = { ArrayType<Point>{ {0, 0}, {1, 0} } };
+  ShapeSpace incremental(depth, space, shape);
+
+  for (int x = -1; x < 6; ++x)
+  {
+    for (int y = -1; y < 6; ++y)
+    {
+      incremental.UpdateShape({ x, y });
+    }
+  }
+
+  space->MakeAreasInaccessable({ Area({ 2, 2 }, { 3, 4 }) });
+  space->SetAccess(Area({ 4, 0 }, { 0, 1 }), Access::Inaccessable);
+
+  ShapeSpace fresh(depth, space, shape);
+  for (int x = -1; x < 6; ++x)
+  {
+    for (int y = -1; y < 6; ++y)
+    {
+      Point point{ x, y };
+      incremental.UpdateShape(point);
+      fresh.UpdateShape(point);
+
+      ASSERT_EQ(incremental.ContainsSegmentsIn(point), fresh.ContainsSegmentsIn(point));
+      if (!fresh.ContainsSegmentsIn(point)) continue;
+      ASSERT_EQ(incremental.GetSegments(point), fresh.GetSegments(point));
+    }
+  }
+
+  SegmentHolder reserved(Segment{ 0, depth });
+  reserved.RemoveSegment({ 3, 4 });
+  ASSERT_EQ(incremental.GetSegments({ 1, 2 }), reserved);
+  ASSERT_EQ(incremental.GetSegments({ 3, 2 }), SegmentHolder(Segment{ 0, depth }));
+}
+
+TEST(AgentTest, ShapeSpaceFollowsTime)
+{
+  RawSpace baseSpace(5, 5);
+  for (int x = 0; x < 5; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      if (x != 2 || y != 4) baseSpace.SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Time depth = 10;
+  std::shared_ptr<SpaceTime> space = std::make_shared<SpaceTime>(depth, baseSpace);
+  Shape shape = { ArrayType<Point>{ {0, 0}, {1, 0} } };
+  ShapeSpace incremental(depth, space, shape);
+
+  space->MakeAreasInaccessable({ Area({ 2, 2 }, { 3, 4 }), Area({ 3, 1 }, { 1, 8 }) });
+  for (int x = -1; x < 6; ++x)
+  {
+    for (int y = -1; y < 6; ++y)
+    {
+      incremental.UpdateShape({ x, y });
+    }
+  }
+
+  // Footprints are shifted without being recomputed
+  space->MoveTime(2);
+  space->MoveTime(1.5f);
+
+  ShapeSpace fresh(depth, space, shape);
+  for (int x = -1; x < 6; ++x)
+  {
+    for (int y = -1; y < 6; ++y)
+    {
+      Point point{ x, y };
+      incremental.UpdateShape(point);
+      fresh.UpdateShape(point);
+
+      ASSERT_EQ(incremental.ContainsSegmentsIn(point), fresh.ContainsSegmentsIn(point));
+      if (!fresh.ContainsSegmentsIn(point)) continue;
+      ASSERT_EQ(incremental.GetSegments(point), fresh.GetSegments(point));
+    }
+  }
+
+  SegmentHolder reserved(Segment{ 0, depth });
+  reserved.RemoveSegment({ 0, 0.5f });
+  ASSERT_EQ(incremental.GetSegments({ 1, 2 }), reserved);
+  ASSERT_FALSE(incremental.ContainsSegmentsIn({ 1, 4 }));
+}
+
+TEST(AgentTest, ShapeSpaceOnSnapshots)
+{
+  RawSpace baseSpace(20, 20);
+  for (int x = 0; x < 20; ++x)
+  {
+    for (int y = 0; y < 20; ++y)
+    {
+      baseSpace.SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Time depth = 10;
+  std::shared_ptr<SpaceTime> space = std::make_shared<SpaceTime>(depth, baseSpace);
+  SegmentSpacePublisher publisher(space);
+  Shape shape = { ArrayType<Point>{ {0, 0}, {1, 0} } };
+  ShapeSpace reader(depth, publisher.GetSnapshot(), shape);
+
+  for (int x = -1; x < 21; ++x)
+  {
+    for (int y = -1; y < 21; ++y)
+    {
+      reader.UpdateShape({ x, y });
+    }
+  }
+
+  space->MakeAreasInaccessable({ Area({ 16, 2 }, { 3, 4 }), Area({ 0, 19 }, { 0, 10 }) });
+  reader.SetSnapshot(publisher.Publish());
+
+  ShapeSpace fresh(depth, space, shape);
+  for (int x = -1; x < 21; ++x)
+  {
+    for (int y = -1; y < 21; ++y)
+    {
+      Point point{ x, y };
+      reader.UpdateShape(point);
+      fresh.UpdateShape(point);
+
+      ASSERT_EQ(reader.ContainsSegmentsIn(point), fresh.ContainsSegmentsIn(point));
+      if (!fresh.ContainsSegmentsIn(point)) continue;
+      ASSERT_EQ(reader.GetSegments(point), fresh.GetSegments(point));
+    }
+  }
+
+  SegmentHolder reserved(Segment{ 0, depth });
+  reserved.RemoveSegment({ 3, 4 });
+  ASSERT_EQ(reader.GetSegments({ 15, 2 }), reserved);
+  ASSERT_TRUE(reader.GetSegments({ 0, 19 }) == SegmentHolder());
+}
+
+TEST(AgentTest, ErodeByShape)
+{
+  RawSpace baseSpace(70, 4);
+  for (int x = 0; x < 70; ++x)
+  {
+    for (int y = 0; y < 4; ++y)
+    {
+      if ((x * 7 + y * 3) % 11 != 0) baseSpace.SetAccess({ x, y }, Access::Accessable);
+    }
+  }
+
+  Shape shape = { ArrayType<Point>{ {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0} } };
+  RawSpace eroded = ErodeByShape(baseSpace, shape);
+
+  Time depth = 3;
+  std::shared_ptr<SegmentSpace> space = std::make_shared<SegmentSpace>(depth, baseSpace);
+  ShapeSpace lazySpace(depth, space, shape);
+  ShapeSpace eagerSpace(depth, space, shape, std::make_shared<RawSpace>(eroded));
+
+  for (int x = -1; x < 71; ++x)
+  {
+    for (int y = -1; y < 5; ++y)
+    {
+      Point point{ x, y };
+      lazySpace.UpdateShape(point);
+      eagerSpace.UpdateShape(point);
+      ASSERT_EQ(eagerSpace.ContainsSegmentsIn(point), lazySpace.ContainsSegmentsIn(point));
+
+      if (!eroded.Contains(point)) continue;
+      Access expected = baseSpace.AreAllAccessable(point, shape.shape) ? Access::Accessable : Access::Inaccessable;
+      ASSERT_EQ(eroded.GetAccess(point), expected);
+      ASSERT_EQ(lazySpace.ContainsSegmentsIn(point), expected == Access::Accessable);
+    }
+  }
+}
+
+template<typename HeapType>
+void CheckTies()
+{
+  NodesArena<int> arena;
+  HeapType heap(true, arena);
   std::vector<Node<int>> check = {
       { 8, 10, 5 },
       { 3, 3, 3 },
@@ -402,18 +813,138 @@ TEST(NodesBinaryHeap, CheckTies)
 
   for (auto& i : check)
   {
-    heap.Insert(i);
+    heap.Insert(arena.Add(i));
   }
 
   int counter = 0;
   while (heap.Size())
   {
-    Node<int>* node = heap.PopMin();
-    EXPECT_EQ(node->cell, counter);
+    NodeID node = heap.PopMin();
+    EXPECT_EQ(arena[node].cell, counter);
     counter++;
   }
 }
 
+// Lazy open lists push an entry for every improvement and may stop before popping all outdated ones
+template<typename HeapType>
+void CheckImproveTime(size_t expectedPushes = 20, size_t expectedPops = 20)
+{
+  NodesArena<int> arena;
+  HeapType heap(true, arena);
+  for (int i = 0; i < 20; ++i)
+  {
+    heap.Insert(arena.Add({ i, Time(10 + i), 0 }));
+  }
+
+  heap.ImproveTime(15, 5);
+  heap.ImproveTime(7, 4);
+  heap.ImproveTime(19, 1);
+
+  std::vector<int> order = { 19, 7, 15, 0, 1, 2, 3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, 16, 17, 18 };
+  for (int cell : order)
+  {
+    NodeID node = heap.PopMin();
+    ASSERT_NE(node, INVALID_NODE_ID);
+    EXPECT_EQ(arena[node].cell, cell);
+  }
+  EXPECT_EQ(heap.PopMin(), INVALID_NODE_ID);
+  EXPECT_EQ(heap.GetPushesCount(), expectedPushes);
+  EXPECT_EQ(heap.GetPopsCount(), expectedPops);
+
+  heap.Reset();
+  EXPECT_EQ(heap.GetPushesCount(), 0);
+  EXPECT_EQ(heap.GetPopsCount(), 0);
+}
+
+TEST(NodesBinaryHeap, CheckTies)
+{
+  CheckTies<NodesBinaryHeap<int>>();
+}
+
+TEST(NodesBinaryHeap, ImproveTime)
+{
+  CheckImproveTime<NodesBinaryHeap<int>>();
+}
+
+TEST(NodesDaryHeap, CheckTies)
+{
+  CheckTies<NodesDaryHeap<int, 2>>();
+  CheckTies<NodesDaryHeap<int, 4>>();
+  CheckTies<NodesDaryHeap<int, 8>>();
+}
+
+TEST(NodesDaryHeap, ImproveTime)
+{
+  CheckImproveTime<NodesDaryHeap<int, 2>>();
+  CheckImproveTime<NodesDaryHeap<int, 4>>();
+  CheckImproveTime<NodesDaryHeap<int, 8>>();
+}
+
+TEST(NodesBucketQueue, CheckTies)
+{
+  CheckTies<NodesBucketQueue<int>>();
+  CheckTies<NodesBucketQueue<int, 1>>();
+}
+
+TEST(NodesBucketQueue, ImproveTime)
+{
+  // The outdated entry of the last improved node is never popped
+  CheckImproveTime<NodesBucketQueue<int>>(23, 22);
+  CheckImproveTime<NodesBucketQueue<int, 1>>(23, 22);
+}
+
+TEST(NodesFocalList, CheckTies)
+{
+  // With the bound 1 the focal list pops nodes in the same order as the heaps
+  CheckTies<NodesFocalList<int>>();
+}
+
+TEST(NodesFocalList, ImproveTime)
+{
+  CheckImproveTime<NodesFocalList<int>>(23, 22);
+}
+
+TEST(NodesFocalList, SuboptimalityBound)
+{
+  NodesArena<int> arena;
+  NodesFocalList<int> focal(true, arena);
+  focal.SetSuboptimalityBound(1.5f);
+
+  // f = 10, 14, 15 and 16, the last one is above the bound
+  focal.Insert(arena.Add({ 0, 2, 8 }));
+  focal.Insert(arena.Add({ 1, 10, 4 }));
+  focal.Insert(arena.Add({ 2, 14, 1 }));
+  focal.Insert(arena.Add({ 3, 16, 0 }));
+
+  ASSERT_EQ(arena[focal.PopMin()].cell, 2);
+  ASSERT_EQ(arena[focal.PopMin()].cell, 1);
+
+  // The improved node lowers min f to 5, so the bound excludes the node with f = 10
+  focal.ImproveTime(3, 5);
+  ASSERT_EQ(arena[focal.PopMin()].cell, 3);
+  ASSERT_EQ(arena[focal.PopMin()].cell, 0);
+  ASSERT_EQ(focal.PopMin(), INVALID_NODE_ID);
+}
+
+TEST(NodesLookup, DenseAndSparsePoints)
+{
+  NodesLookup<Point> lookup;
+  lookup.Set({ 1, 1 }, 3);
+  lookup.SetBounds(2, 2);
+  lookup.Set({ 0, 1 }, 4);
+  lookup.Set({ -1, 5 }, 5);
+
+  EXPECT_EQ(lookup.Find({ 1, 1 }), 3);
+  EXPECT_EQ(lookup.Find({ 0, 1 }), 4);
+  EXPECT_EQ(lookup.Find({ -1, 5 }), 5);
+  EXPECT_EQ(lookup.Find({ 0, 0 }), INVALID_NODE_ID);
+  EXPECT_EQ(lookup.Find({ 7, 0 }), INVALID_NODE_ID);
+
+  lookup.Clear();
+  EXPECT_EQ(lookup.Find({ 1, 1 }), INVALID_NODE_ID);
+  EXPECT_EQ(lookup.Find({ -1, 5 }), INVALID_NODE_ID);
+}
+
 
 int main(int argc, char* argv[])
 {